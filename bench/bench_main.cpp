@@ -0,0 +1,267 @@
+#include "corpus.hpp"
+#include "harness.hpp"
+#include "file_scanner.hpp"
+#include "grep_engine.hpp"
+#include "literal_searcher.hpp"
+#include "options.hpp"
+#include "re2_matcher.hpp"
+#include "regex_matcher.hpp"
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace cpp_ripgrep;
+using namespace cpp_ripgrep::bench;
+
+namespace {
+
+const char* const kRegex = "needle_[0-9]+";
+
+struct BenchOptions {
+    Harness::Config harness;
+    size_t size = 8 * 1024 * 1024;
+    std::vector<size_t> line_lengths = {80, 400};
+    std::vector<double> hit_rates = {0.0, 0.01, 0.25};
+};
+
+void print_usage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " [OPTIONS]\n"
+              << "\n"
+              << "Options:\n"
+              << "  --filter TEXT         Run only benchmarks whose name contains TEXT\n"
+              << "  --min-time SECONDS    Time measured per benchmark (default: 0.5)\n"
+              << "  --size SIZE           Corpus size (K, M or G suffix; default: 8M)\n"
+              << "  --line-length N       Mean line length (default: 80 and 400)\n"
+              << "  --hit-rate FRACTION   Fraction of lines that match (default: 0, 0.01 and 0.25)\n"
+              << "  --save FILE           Save the results as a baseline\n"
+              << "  --compare FILE        Compare with a saved baseline; exits 1 on regressions\n"
+              << "  --threshold PERCENT   Slowdown counted as a regression (default: 10)\n"
+              << "  -h, --help            Show this help message\n";
+}
+
+BenchOptions parse(int argc, char* argv[]) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            std::exit(0);
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Error: Unknown option or missing value: " << arg << "\n";
+            std::exit(1);
+        }
+        const std::string value = argv[++i];
+        if (arg == "--filter") {
+            options.harness.filter = value;
+        } else if (arg == "--min-time") {
+            options.harness.min_time = std::stod(value);
+        } else if (arg == "--size") {
+            options.size = OptionsParser::parse_size(value);
+        } else if (arg == "--line-length") {
+            options.line_lengths = {std::stoul(value)};
+        } else if (arg == "--hit-rate") {
+            options.hit_rates = {std::stod(value)};
+        } else if (arg == "--save") {
+            options.harness.save_path = value;
+        } else if (arg == "--compare") {
+            options.harness.compare_path = value;
+        } else if (arg == "--threshold") {
+            options.harness.threshold = std::stod(value);
+        } else {
+            std::cerr << "Error: Unknown option: " << arg << "\n";
+            std::exit(1);
+        }
+    }
+    return options;
+}
+
+// Options for a plain search of `pattern`, as the command line would set them
+Options search_options(const std::string& pattern, SearchMode mode, size_t threads) {
+    Options options;
+    options.pattern = pattern;
+    options.patterns = {pattern};
+    options.mode = mode;
+    options.threads = static_cast<int>(threads);
+    options.no_ignore = true;
+    return options;
+}
+
+// Sink that only counts, as cheaply as a real consumer could
+class CountingSink : public SearchSink {
+public:
+    void match(const SinkMatch& match) override {
+        lines_.fetch_add(1, std::memory_order_relaxed);
+        spans_.fetch_add(match.matches.size(), std::memory_order_relaxed);
+    }
+
+    size_t lines() const { return lines_.load(); }
+
+private:
+    std::atomic<size_t> lines_{0};
+    std::atomic<size_t> spans_{0};
+};
+
+void bench_matchers(Harness& harness, const BenchOptions& options) {
+    const LiteralSearcher literal(kNeedle);
+    RegexMatcher pcre2(kRegex);
+    RegexMatcher pcre2_caseless(kRegex, true);
+    RE2Matcher re2(kRegex);
+    Options scanner_options;
+    const FileScanner scanner(scanner_options);
+
+    for (size_t line_length : options.line_lengths) {
+        for (double hit_rate : options.hit_rates) {
+            CorpusSpec spec;
+            spec.size = options.size;
+            spec.line_length = line_length;
+            spec.hit_rate = hit_rate;
+            const std::string text = make_corpus(spec);
+            const std::vector<std::string_view> lines = split_lines(text);
+            const std::string label = " " + spec.label();
+
+            harness.run("LiteralSearcher::find_all" + label, text.size(), [&] {
+                consume(literal.find_all(text).size());
+            });
+            harness.run("literal_match" + label, text.size(), [&] {
+                size_t hits = 0;
+                for (std::string_view line : lines) {
+                    hits += RegexMatcher::literal_match(line, kNeedle);
+                }
+                consume(hits);
+            });
+            harness.run("literal_match -i" + label, text.size(), [&] {
+                size_t hits = 0;
+                for (std::string_view line : lines) {
+                    hits += RegexMatcher::literal_match(line, "NEEDLE", true);
+                }
+                consume(hits);
+            });
+            if (pcre2.is_valid()) {
+                harness.run("RegexMatcher::find_all" + label, text.size(), [&] {
+                    consume(pcre2.find_all(text).size());
+                });
+                harness.run("RegexMatcher::find_all -i" + label, text.size(), [&] {
+                    consume(pcre2_caseless.find_all(text).size());
+                });
+            }
+            if (re2.is_valid()) {
+                harness.run("RE2Matcher::find_all" + label, text.size(), [&] {
+                    consume(re2.find_all(text).size());
+                });
+            }
+            harness.run("FileScanner::get_lines" + label, text.size(), [&] {
+                consume(scanner.get_lines(text).size());
+            });
+        }
+    }
+}
+
+void bench_files(Harness& harness, const BenchOptions& options) {
+    CorpusSpec spec;
+    spec.size = options.size;
+    spec.line_length = options.line_lengths.front();
+    spec.hit_rate = 0.01;
+    const std::string text = make_corpus(spec);
+    const std::string label = " " + spec.label();
+
+    // The same corpus as one file and spread over a tree of small ones
+    constexpr size_t kSmallFiles = 256;
+    TempTree tree("files");
+    const std::string large = tree.write_file("large/corpus.txt", text);
+    std::vector<std::string> small;
+    const size_t piece = text.size() / kSmallFiles;
+    for (size_t i = 0; i < kSmallFiles; ++i) {
+        const std::string name = "small/dir" + std::to_string(i % 16) + "/file" + std::to_string(i) + ".txt";
+        small.push_back(tree.write_file(name, std::string_view(text).substr(i * piece, piece)));
+    }
+
+    for (IoBackend backend : {IoBackend::MMAP, IoBackend::PREAD}) {
+        Options scanner_options;
+        scanner_options.io_backend = backend;
+        const FileScanner scanner(scanner_options);
+        const std::string io = backend == IoBackend::MMAP ? " mmap" : " pread";
+
+        harness.run("FileScanner::read_file 1 file" + io, text.size(), [&] {
+            consume(scanner.read_file(large).size());
+        });
+        harness.run("FileScanner::read_file " + std::to_string(kSmallFiles) + " files" + io,
+                    piece * kSmallFiles, [&] {
+            size_t bytes = 0;
+            for (const auto& path : small) {
+                bytes += scanner.read_file(path).size();
+            }
+            consume(bytes);
+        });
+    }
+
+    // Paths shaped like a source tree, filtered as with --include/--exclude
+    {
+        Options filter_options;
+        filter_options.include_patterns = {"*.cpp", "*.hpp", "src/**/*.h"};
+        filter_options.exclude_patterns = {"*.min.js", "build/**", "third_party/*"};
+        const FileScanner scanner(filter_options);
+
+        const char* const extensions[] = {".cpp", ".hpp", ".h", ".js", ".min.js", ".md", ".txt", ".o"};
+        const char* const roots[] = {"src", "include", "build", "third_party", "docs", "tests"};
+        std::vector<std::string> paths;
+        size_t path_bytes = 0;
+        for (size_t i = 0; i < 10000; ++i) {
+            paths.push_back(std::string(roots[i % 6]) + "/module" + std::to_string(i % 97) + "/file" +
+                            std::to_string(i) + extensions[i % 8]);
+            path_bytes += paths.back().size();
+        }
+        harness.run("FileScanner::should_scan_file 10000 paths", path_bytes, [&] {
+            size_t selected = 0;
+            for (const auto& path : paths) {
+                selected += scanner.should_scan_file(path);
+            }
+            consume(selected);
+        });
+    }
+
+    // End to end through the library API; each engine is reused across
+    // iterations, as an embedding program would
+    std::vector<size_t> thread_counts = {1};
+    if (std::thread::hardware_concurrency() > 1) {
+        thread_counts.push_back(std::thread::hardware_concurrency());
+    }
+    for (size_t threads : thread_counts) {
+        const std::string suffix = label + " -j" + std::to_string(threads);
+        struct Case {
+            const char* name;
+            std::string pattern;
+            SearchMode mode;
+        };
+        for (const Case& search : {Case{"GrepEngine::search literal", kNeedle, SearchMode::LITERAL},
+                                   Case{"GrepEngine::search regex", kRegex, SearchMode::REGEX}}) {
+            if (!harness.enabled(search.name + suffix)) {
+                continue;
+            }
+            GrepEngine engine(search_options(search.pattern, search.mode, threads));
+            if (!engine.is_valid()) {
+                continue;
+            }
+            const std::vector<std::string> roots = {tree.path() + "/small"};
+            harness.run(search.name + suffix, piece * kSmallFiles, [&] {
+                CountingSink sink;
+                consume(engine.search(roots, sink).matched_lines + sink.lines());
+            });
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options = parse(argc, argv);
+    Harness harness(options.harness);
+
+    bench_matchers(harness, options);
+    bench_files(harness, options);
+
+    return harness.finish();
+}
@@ -0,0 +1,112 @@
+#include "corpus.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+namespace cpp_ripgrep {
+namespace bench {
+
+namespace {
+
+// Filler words; none of them contains the needle
+const char* const kWords[] = {
+    "the", "of", "and", "to", "in", "is", "for", "on", "with", "as", "by", "at", "from",
+    "value", "index", "buffer", "return", "const", "string", "result", "search", "file",
+    "thread", "worker", "option", "pattern", "match", "line", "offset", "count", "size",
+    "static", "struct", "class", "public", "private", "template", "vector", "error",
+};
+constexpr size_t kWordCount = sizeof(kWords) / sizeof(kWords[0]);
+
+} // namespace
+
+std::string CorpusSpec::label() const {
+    const double percent = hit_rate * 100;
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "%zuB/%g%%", line_length, percent);
+    return buffer;
+}
+
+std::string make_corpus(const CorpusSpec& spec) {
+    std::mt19937_64 random(spec.seed);
+    std::uniform_int_distribution<size_t> length(spec.line_length / 2, spec.line_length + spec.line_length / 2);
+    std::uniform_int_distribution<size_t> word(0, kWordCount - 1);
+    std::uniform_int_distribution<int> digit(0, 9);
+    std::bernoulli_distribution hit(spec.hit_rate);
+
+    std::string text;
+    text.reserve(spec.size + spec.line_length * 2);
+    while (text.size() < spec.size) {
+        const size_t target = text.size() + length(random);
+        const bool is_hit = hit(random);
+        bool needle_placed = false;
+
+        while (text.size() < target || (is_hit && !needle_placed)) {
+            if (text.size() > 0 && text.back() != '\n') {
+                text += ' ';
+            }
+            // Put the needle somewhere along the line rather than always first
+            if (is_hit && !needle_placed && (text.size() + 16 >= target || digit(random) == 0)) {
+                text += kNeedle;
+                text += '_';
+                for (int i = 0; i < 3; ++i) {
+                    text += static_cast<char>('0' + digit(random));
+                }
+                needle_placed = true;
+                continue;
+            }
+            text += kWords[word(random)];
+        }
+        text += '\n';
+    }
+    return text;
+}
+
+std::vector<std::string_view> split_lines(std::string_view text) {
+    std::vector<std::string_view> lines;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find('\n', start);
+        if (end == std::string_view::npos) {
+            end = text.size();
+        }
+        lines.push_back(text.substr(start, end - start));
+        start = end + 1;
+    }
+    return lines;
+}
+
+TempTree::TempTree(const std::string& tag) {
+    path_ = (std::filesystem::temp_directory_path() /
+             ("cpp_ripgrep_bench_" + tag + "_" + std::to_string(getpid()))).string();
+    std::filesystem::remove_all(path_);
+    std::filesystem::create_directories(path_);
+}
+
+TempTree::~TempTree() {
+    std::error_code error;
+    std::filesystem::remove_all(path_, error);
+}
+
+std::string TempTree::write_file(const std::string& relative, std::string_view contents) {
+    const std::filesystem::path full = std::filesystem::path(path_) / relative;
+    std::filesystem::create_directories(full.parent_path());
+    std::ofstream out(full, std::ios::binary);
+    out.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+    if (!out) {
+        std::cerr << "Error: Cannot write " << full.string() << "\n";
+        std::exit(1);
+    }
+    return full.string();
+}
+
+} // namespace bench
+} // namespace cpp_ripgrep
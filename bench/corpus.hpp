@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cpp_ripgrep {
+namespace bench {
+
+// Word every hit line contains, followed by '_' and three digits
+constexpr const char* kNeedle = "needle";
+
+// Shape of a synthetic text corpus
+struct CorpusSpec {
+    size_t size = 8 * 1024 * 1024;   // bytes, approximately
+    size_t line_length = 80;         // mean; lines vary by half of it either way
+    double hit_rate = 0.01;          // fraction of lines containing kNeedle
+    uint64_t seed = 42;
+
+    // Short label such as "80B/1%"
+    std::string label() const;
+};
+
+// Lowercase words in lines of the requested shape; nothing but the hits
+// contains kNeedle. The same spec always gives the same text.
+std::string make_corpus(const CorpusSpec& spec);
+
+// Views of the lines of text, without terminators
+std::vector<std::string_view> split_lines(std::string_view text);
+
+// Directory under the system temporary directory, removed on destruction
+class TempTree {
+public:
+    explicit TempTree(const std::string& tag);
+    ~TempTree();
+
+    // Disable copy
+    TempTree(const TempTree&) = delete;
+    TempTree& operator=(const TempTree&) = delete;
+
+    const std::string& path() const { return path_; }
+
+    // Write contents to path()/relative, creating directories; returns the full path
+    std::string write_file(const std::string& relative, std::string_view contents);
+
+private:
+    std::string path_;
+};
+
+} // namespace bench
+} // namespace cpp_ripgrep
@@ -0,0 +1,159 @@
+#include "harness.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+
+namespace {
+
+std::atomic<size_t> g_allocations{0};
+volatile size_t g_consumed = 0;
+
+} // namespace
+
+// Count every allocation in the process, including the engine's workers
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    std::free(memory);
+}
+
+namespace cpp_ripgrep {
+namespace bench {
+
+size_t allocation_count() {
+    return g_allocations.load(std::memory_order_relaxed);
+}
+
+void consume(size_t value) {
+    g_consumed = g_consumed + value;
+}
+
+Harness::Harness(Config config) : config_(std::move(config)) {
+    std::printf("%-48s %12s %12s %12s\n", "benchmark", "MB/s", "ns/op", "allocs/op");
+}
+
+double Harness::now() {
+    using clock = std::chrono::steady_clock;
+    return std::chrono::duration<double>(clock::now().time_since_epoch()).count();
+}
+
+bool Harness::enabled(const std::string& name) const {
+    return config_.filter.empty() || name.find(config_.filter) != std::string::npos;
+}
+
+void Harness::run(const std::string& name, size_t bytes, const std::function<void()>& op) {
+    if (!enabled(name)) {
+        return;
+    }
+
+    // Warm caches, then grow the batch until it takes a tenth of the budget
+    op();
+    uint64_t batch = 1;
+    double elapsed = 0;
+    while (true) {
+        const double start = now();
+        for (uint64_t i = 0; i < batch; ++i) {
+            op();
+        }
+        elapsed = now() - start;
+        if (elapsed >= config_.min_time / 10 || batch >= (uint64_t(1) << 30)) {
+            break;
+        }
+        batch *= 2;
+    }
+
+    Measurement measurement;
+    measurement.name = name;
+    measurement.bytes_per_op = bytes;
+    measurement.iterations = std::max<uint64_t>(1, static_cast<uint64_t>(batch * config_.min_time / elapsed));
+
+    const size_t allocations = allocation_count();
+    const double start = now();
+    for (uint64_t i = 0; i < measurement.iterations; ++i) {
+        op();
+    }
+    measurement.seconds = now() - start;
+    measurement.allocations = allocation_count() - allocations;
+
+    std::printf("%-48s %12.1f %12.0f %12.2f\n", name.c_str(), measurement.bytes_per_second() / (1024 * 1024),
+                measurement.ns_per_op(), measurement.allocs_per_op());
+    std::fflush(stdout);
+    results_.push_back(std::move(measurement));
+}
+
+int Harness::finish() const {
+    if (!config_.save_path.empty()) {
+        std::ofstream out(config_.save_path);
+        if (!out) {
+            std::cerr << "Error: Cannot write baseline: " << config_.save_path << "\n";
+            return 1;
+        }
+        // name, ns/op, allocs/op; tab separated since names contain spaces
+        for (const auto& result : results_) {
+            out << result.name << '\t' << result.ns_per_op() << '\t' << result.allocs_per_op() << '\n';
+        }
+    }
+
+    if (config_.compare_path.empty()) {
+        return 0;
+    }
+
+    std::ifstream in(config_.compare_path);
+    if (!in) {
+        std::cerr << "Error: Cannot read baseline: " << config_.compare_path << "\n";
+        return 1;
+    }
+    std::map<std::string, std::pair<double, double>> baseline;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string name;
+        double ns = 0;
+        double allocs = 0;
+        if (std::getline(fields, name, '\t') && fields >> ns >> allocs) {
+            baseline[name] = {ns, allocs};
+        }
+    }
+
+    std::printf("\n%-48s %12s %12s\n", "compared to baseline", "time", "allocs/op");
+    int regressions = 0;
+    for (const auto& result : results_) {
+        auto it = baseline.find(result.name);
+        if (it == baseline.end()) {
+            continue;
+        }
+        const double change = (result.ns_per_op() / it->second.first - 1) * 100;
+        const bool slower = change > config_.threshold;
+        // Allocation counts barely vary between runs, so growth beyond a
+        // few percent is real
+        const bool allocates_more = result.allocs_per_op() > it->second.second * 1.05 + 0.5;
+        std::printf("%-48s %+11.1f%% %12.2f%s\n", result.name.c_str(), change, result.allocs_per_op(),
+                    slower || allocates_more ? "  REGRESSED" : "");
+        regressions += slower || allocates_more;
+    }
+    if (regressions > 0) {
+        std::printf("\n%d benchmark(s) regressed\n", regressions);
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace bench
+} // namespace cpp_ripgrep
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace cpp_ripgrep {
+namespace bench {
+
+// Heap allocations made by any thread so far, counted by the global
+// operator new this binary replaces (aligned allocations are not counted)
+size_t allocation_count();
+
+// Keep a result alive so the optimizer cannot drop the work producing it
+void consume(size_t value);
+
+struct Measurement {
+    std::string name;
+    uint64_t iterations = 0;
+    double seconds = 0;
+    size_t bytes_per_op = 0;
+    size_t allocations = 0;
+
+    double ns_per_op() const { return seconds * 1e9 / static_cast<double>(iterations); }
+    double bytes_per_second() const { return static_cast<double>(bytes_per_op) * iterations / seconds; }
+    double allocs_per_op() const { return static_cast<double>(allocations) / static_cast<double>(iterations); }
+};
+
+// Runs benchmarks, prints one row per benchmark and optionally saves the
+// results as a baseline or compares them against an earlier one.
+class Harness {
+public:
+    struct Config {
+        double min_time = 0.5;        // seconds measured per benchmark
+        std::string filter;           // run only names containing this
+        std::string save_path;        // write results here
+        std::string compare_path;     // baseline to compare against
+        double threshold = 10.0;      // percent slowdown reported as a regression
+    };
+
+    explicit Harness(Config config);
+
+    bool enabled(const std::string& name) const;
+
+    // Call op repeatedly for at least min_time seconds; `bytes` is the input
+    // one call processes
+    void run(const std::string& name, size_t bytes, const std::function<void()>& op);
+
+    // Save and compare as configured; returns the exit status, nonzero when
+    // a benchmark regressed against the baseline
+    int finish() const;
+
+private:
+    Config config_;
+    std::vector<Measurement> results_;
+
+    static double now();
+};
+
+} // namespace bench
+} // namespace cpp_ripgrep
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "common.hpp"
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <cstdint>
+
+namespace cpp_ripgrep {
+
+// Multi-pattern literal matcher built on an Aho-Corasick automaton.
+//
+// The automaton is stored as a dense DFA: every state has a full row of
+// transitions, indexed by byte class rather than by byte. Bytes that do not
+// occur in any pattern share one class, so rows stay short and a search
+// step is a single table load. Matches follow leftmost-longest semantics
+// and carry the index of the pattern that produced them.
+class AhoCorasickMatcher {
+public:
+    explicit AhoCorasickMatcher(const std::vector<std::string>& patterns, bool case_insensitive = false);
+
+    // Check if the pattern set is usable
+    bool is_valid() const { return error_.empty(); }
+    std::string get_error() const { return error_; }
+
+    // Find all non-overlapping matches in a string
+    std::vector<Match> find_all(std::string_view text) const;
+
+    // Check if the whole string equals one of the patterns
+    bool matches(std::string_view text) const;
+
+    // Find first match
+    std::optional<Match> find_first(std::string_view text) const;
+
+    // Find the next match at or after start_offset, e.g. across a whole file buffer
+    std::optional<MatchRange> find_next(std::string_view text, size_t start_offset) const;
+
+    size_t pattern_count() const { return patterns_.size(); }
+    size_t state_count() const { return depth_.size(); }
+
+private:
+    static constexpr uint32_t kRoot = 0;
+    static constexpr uint32_t kNoPattern = UINT32_MAX;
+
+    struct Hit {
+        size_t start;
+        size_t end;
+        uint32_t pattern;
+    };
+
+    std::vector<std::string> patterns_;
+    bool case_insensitive_;
+    std::string error_;
+
+    uint16_t byte_class_[256];
+    size_t stride_ = 0;                  // number of byte classes
+    std::vector<uint32_t> transitions_;  // state * stride_ + class -> state
+    std::vector<uint32_t> depth_;        // length of the string a state spells
+    std::vector<uint32_t> output_;       // pattern ending exactly at the state
+    std::vector<uint32_t> output_link_;  // nearest proper suffix state with an output
+    std::string start_bytes_;            // prefilter bytes when the set is small
+
+    void build();
+    std::optional<Hit> find_leftmost(std::string_view text, size_t start_offset) const;
+
+    uint32_t next_state(uint32_t state, unsigned char byte) const {
+        return transitions_[state * stride_ + byte_class_[byte]];
+    }
+};
+
+} // namespace cpp_ripgrep
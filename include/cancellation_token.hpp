@@ -0,0 +1,21 @@
+#pragma once
+
+#include <atomic>
+
+namespace cpp_ripgrep {
+
+// Shared stop flag for a search. Once cancelled, the walker hands out no
+// more work and workers abandon the file they are on at the next line.
+class CancellationToken {
+public:
+    void cancel() { cancelled_.store(true, std::memory_order_release); }
+    bool is_cancelled() const { return cancelled_.load(std::memory_order_acquire); }
+
+    // Clear the flag so the owner can search again
+    void reset() { cancelled_.store(false, std::memory_order_release); }
+
+private:
+    std::atomic<bool> cancelled_{false};
+};
+
+} // namespace cpp_ripgrep
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace cpp_ripgrep {
+
+// Streaming reader for files too large to map.
+//
+// Reads into one reusable buffer and hands out chunks that always end on a
+// line boundary: the partial line at the end of a read is carried over to
+// the front of the buffer and completed by the next read. The buffer grows
+// for a line longer than the chunk size, up to max_line_size; a longer
+// line is handed out in pieces of that size, so memory stays bounded
+// however big the file is and whether or not it has newlines.
+//
+// Gzip files (-z) are inflated on the fly: compressed input is read in
+// fixed-size blocks and decompressed straight into the chunk buffer, so
+// chunks and line numbers refer to the decompressed stream.
+class ChunkReader {
+public:
+#ifdef _WIN32
+    using NativeHandle = void*;
+#else
+    using NativeHandle = int;
+#endif
+
+    enum class Compression {
+        NONE,
+        GZIP    // one or more concatenated gzip members
+    };
+
+    static constexpr size_t kDefaultChunkSize = 1024 * 1024;
+    static constexpr size_t kMaxLineSize = 16 * 1024 * 1024;
+    static constexpr size_t kCompressedBlockSize = 64 * 1024;
+
+    // Takes ownership of an open file handle. With a nonzero binary_probe,
+    // a NUL byte among the first binary_probe bytes ends the stream after
+    // the first read, which is then the only chunk, so a binary file is
+    // recognized without reading the rest of it.
+    explicit ChunkReader(NativeHandle handle, size_t chunk_size = kDefaultChunkSize,
+                         Compression compression = Compression::NONE, size_t binary_probe = 0,
+                         size_t max_line_size = kMaxLineSize);
+    ~ChunkReader();
+
+    // Disable copy
+    ChunkReader(const ChunkReader&) = delete;
+    ChunkReader& operator=(const ChunkReader&) = delete;
+
+    // Next run of whole lines; only the last chunk of a file, a piece of an
+    // over-long line, or a binary file's first read may lack a trailing
+    // '\n'. The view is valid until the following call. Returns false once
+    // the file is exhausted.
+    bool next(std::string_view& chunk);
+
+private:
+    NativeHandle handle_;
+    std::vector<char> buffer_;
+    size_t max_line_size_;
+    size_t binary_probe_;     // 0 once the first read has been checked
+    size_t tail_start_ = 0;   // partial line left over from the last chunk
+    size_t tail_end_ = 0;
+    bool eof_ = false;
+
+    // zlib state for Compression::GZIP
+    struct Inflater;
+    std::unique_ptr<Inflater> inflater_;
+
+    // Read (and inflate) into `size` bytes at `data`; 0 at end of file
+    size_t read_some(char* data, size_t size);
+    
+    // Read raw file bytes
+    size_t read_raw(char* data, size_t size);
+    
+    size_t inflate_some(char* data, size_t size);
+    
+    static void close_handle(NativeHandle handle);
+};
+
+} // namespace cpp_ripgrep
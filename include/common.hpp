@@ -8,6 +8,13 @@ struct Match {
     size_t start;
     size_t end;
     std::string text;
+    size_t pattern_index = 0; // which of several -e/-f patterns matched
+};
+
+// Byte range of a match, used on hot paths where the text is not needed
+struct MatchRange {
+    size_t start;
+    size_t end;
 };
 
 } // namespace cpp_ripgrep 
\ No newline at end of file
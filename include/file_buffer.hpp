@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+namespace cpp_ripgrep {
+
+// Read-only file contents that can be searched in place. Files are normally
+// backed by a memory mapping of the page cache; an owned heap buffer is only
+// used when mapping is not possible or not worthwhile.
+class FileBuffer {
+public:
+    FileBuffer() = default;
+    ~FileBuffer();
+
+    // Disable copy
+    FileBuffer(const FileBuffer&) = delete;
+    FileBuffer& operator=(const FileBuffer&) = delete;
+
+    // Allow move
+    FileBuffer(FileBuffer&& other) noexcept;
+    FileBuffer& operator=(FileBuffer&& other) noexcept;
+
+    // Take ownership of a mapped view of `size` bytes
+    static FileBuffer from_mapping(void* address, size_t size);
+
+    // Take ownership of heap-allocated contents
+    static FileBuffer from_string(std::string contents);
+
+    std::string_view view() const { return std::string_view(data_, size_); }
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    bool is_mapped() const { return mapping_ != nullptr; }
+
+    // Hide everything from `size` on; the mapping itself is kept whole
+    void truncate(size_t size);
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    void* mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+    std::string owned_;
+
+    void cleanup();
+    void move_from(FileBuffer&& other);
+};
+
+} // namespace cpp_ripgrep
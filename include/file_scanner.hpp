@@ -1,6 +1,12 @@
 #pragma once
 
+#include "chunk_reader.hpp"
+#include "file_buffer.hpp"
+#include "glob_set.hpp"
+#include "ignore_rules.hpp"
+#include "metadata_cache.hpp"
 #include <string>
+#include <string_view>
 #include <vector>
 #include <functional>
 #include <memory>
@@ -36,29 +42,95 @@ public:
     void scan(const std::vector<std::string>& paths, 
               std::function<void(const FileInfo&)> file_callback);
     
-    // Read file content with memory mapping
-    std::string read_file(const std::string& path) const;
+    // Classify root paths: directories to walk and files to search
+    void scan_roots(const std::vector<std::string>& paths,
+                    const std::function<void(const std::string&)>& directory_callback,
+                    const std::function<void(const FileInfo&)>& file_callback) const;
+    
+    // List a single directory (not recursively), reporting subdirectories
+    // to descend into and files that pass the include/exclude filters.
+    // Entries matched by the ignore rules in effect (`inherited` plus the
+    // directory's own ignore files) are skipped, so ignored subtrees are
+    // never opened; subdirectories are reported with the rules they inherit.
+    void read_directory(const std::string& path, const IgnoreRules::Ptr& inherited,
+                        const std::function<void(const std::string&, const IgnoreRules::Ptr&)>& directory_callback,
+                        const std::function<void(const FileInfo&)>& file_callback) const;
+    
+    // Files above this size are streamed instead of mapped
+    static constexpr size_t kMaxMappedSize = 100 * 1024 * 1024;
+    
+    // Read file content with memory mapping. Binary files (a NUL byte in
+    // the first block) come back empty; with --stop-at-nul the contents also
+    // end before the line holding the first NUL anywhere in the file.
+    // When `stream` is given, files above max_mapped_size are not read at
+    // all: *stream is set to a ChunkReader and the buffer is empty. With
+    // -z, gzip files (by their magic bytes) always come back as a stream
+    // of decompressed contents.
+    FileBuffer read_file(const std::string& path, std::unique_ptr<ChunkReader>* stream = nullptr,
+                         size_t max_mapped_size = kMaxMappedSize) const;
+    
+    // Apply binary detection to contents read some other way (io_uring)
+    FileBuffer filter_binary(FileBuffer buffer) const;
+    
+    // Where problems found while walking go instead of standard error: a
+    // path that cannot be searched (error) or is passed over (warning).
+    // Set only while no walk is running; empty handlers restore stderr.
+    using DiagnosticHandler = std::function<void(const std::string& path, const std::string& message)>;
+    void set_diagnostic_handlers(DiagnosticHandler warning, DiagnosticHandler error);
+    
+    // --cache: write back what this run learned about files
+    void save_cache() const;
+    const MetadataCache* cache() const { return cache_.get(); }
+    
+    // Length of the prefix of `content` to search, applying the binary
+    // rules read_file uses; `at_file_start` enables the first-block check
+    size_t searchable_length(std::string_view content, bool at_file_start) const;
     
     // Get lines from file content
-    std::vector<LineInfo> get_lines(const std::string& content) const;
+    std::vector<LineInfo> get_lines(std::string_view content) const;
     
-    // Check if file should be included/excluded
+    // Check if file should be included/excluded; globs without a '/' match
+    // the file name, others the whole path
     bool should_scan_file(const std::string& path) const;
     
+    // Whether a directory met while walking should be entered: --exclude
+    // globs prune it with everything below, and an exclude ending in '/'
+    // matches only directories. --include globs apply to files alone.
+    bool should_scan_directory(const std::string& path) const;
+    
     // Get file info
     static FileInfo get_file_info(const std::string& path);
 
 private:
     const Options& options_;
     
-    void scan_directory(const std::string& path, int depth,
+    void scan_directory(const std::string& path, int depth, const IgnoreRules::Ptr& ignore,
                        std::function<void(const FileInfo&)> file_callback);
     
-    bool matches_pattern(const std::string& path, 
-                        const std::vector<std::string>& patterns) const;
+    DiagnosticHandler on_warning_;
+    DiagnosticHandler on_error_;
+    
+    // --cache: binary classification of files by device, inode and mtime
+    std::unique_ptr<MetadataCache> cache_;
+    
+    // Gzip magic bytes
+    static bool is_gzip(const unsigned char* magic);
+    
+    // Stream (or fully inflate, without `stream`) a gzip file
+    FileBuffer open_gzip(ChunkReader::NativeHandle handle, std::unique_ptr<ChunkReader>* stream) const;
+    
+    // Binary detection, consulting and feeding the cache when identity is given
+    FileBuffer filter_binary(FileBuffer buffer, const FileIdentity* identity, MetadataCache::Kind known) const;
+    
+    // --include and --exclude globs, tagged by which list they came from
+    std::unique_ptr<GlobSet> filters_;
+    static constexpr unsigned kExcludeTag = 0;
+    static constexpr unsigned kIncludeTag = 1;
+    static constexpr unsigned kExcludeDirectoryTag = 2;   // excludes ending in '/'
+    bool has_excludes_ = false;
     
-    bool is_binary_file(const std::string& path) const;
-    bool is_text_file(const std::string& path) const;
+    // Bytes checked for NUL to classify a file as binary
+    static constexpr size_t kBinaryProbeSize = 1024;
 };
 
 } // namespace cpp_ripgrep 
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace cpp_ripgrep {
+
+// Shell-style glob with path semantics, as used by .gitignore files:
+// `*` and `?` never match '/', `[...]` is a byte class (`!` or `^`
+// negates), a backslash quotes the next byte, and `**` between slashes
+// (or at either end) matches any number of directories.
+//
+// Patterns are classified once when compiled, so the common shapes
+// (plain names and `*.ext`) match with a single comparison.
+class Glob {
+public:
+    Glob() = default;
+    explicit Glob(std::string pattern);
+
+    bool matches(std::string_view text) const;
+
+    const std::string& pattern() const { return pattern_; }
+
+private:
+    enum class Kind {
+        LITERAL,   // no wildcards: whole-text comparison
+        SUFFIX,    // `*` followed by a literal without '/'
+        GENERAL
+    };
+
+    std::string pattern_;
+    std::string literal_;
+    Kind kind_ = Kind::LITERAL;
+
+    static bool match(std::string_view pattern, size_t p, std::string_view text, size_t t);
+    static bool match_class(std::string_view pattern, size_t& p, unsigned char byte);
+};
+
+} // namespace cpp_ripgrep
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "glob.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#ifdef HAVE_RE2
+#include <re2/re2.h>
+#include <re2/set.h>
+#endif
+
+namespace cpp_ripgrep {
+
+// Many globs compiled into one matcher that is evaluated once per path.
+//
+// Every glob carries a tag (a bit index below 32) and a lookup reports the
+// tags of all globs that match, so include and exclude lists can share a
+// single pass. Globs without a '/' match the file name, others match the
+// whole path. The common shapes are answered by hashing: `*.ext` by the
+// name's extension and wildcard-free globs by the name or path itself.
+// The rest are translated to regexes and combined into one RE2::Set per
+// target and tag, so a path costs one DFA pass over its name and one over
+// its full path per tag however many globs there are. A set only answers
+// whether anything matched, which RE2 decides without allocating.
+class GlobSet {
+public:
+    struct Entry {
+        std::string pattern;
+        unsigned tag;
+    };
+
+    explicit GlobSet(const std::vector<Entry>& globs);
+    ~GlobSet();
+
+    // Disable copy
+    GlobSet(const GlobSet&) = delete;
+    GlobSet& operator=(const GlobSet&) = delete;
+
+    bool empty() const { return count_ == 0; }
+
+    // Bit `tag` is set for every tag with a glob matching path
+    uint32_t matches(std::string_view path) const;
+
+private:
+    // Globs the regex translation declines, and every glob without RE2
+    struct Fallback {
+        Glob glob;
+        bool whole_path;
+        uint32_t mask;
+    };
+
+    // Automaton for the globs of one target (name or path) and tag
+    struct Combined {
+#ifdef HAVE_RE2
+        std::unique_ptr<re2::RE2::Set> set;
+#endif
+        uint32_t mask = 0;
+        std::vector<std::string> globs;
+        std::vector<std::string> regexes;
+    };
+
+    // Hash keys are views into keys_, so a lookup never builds a string
+    size_t count_ = 0;
+    std::vector<std::string> keys_;
+    std::unordered_map<std::string_view, uint32_t> extensions_;
+    std::unordered_map<std::string_view, uint32_t> names_;
+    std::unordered_map<std::string_view, uint32_t> paths_;
+    std::vector<Combined> name_sets_;
+    std::vector<Combined> path_sets_;
+    std::vector<Fallback> fallback_;
+
+    void compile(std::vector<Combined>& sets, bool whole_path);
+    static uint32_t match_combined(const std::vector<Combined>& sets, std::string_view text, uint32_t known);
+
+    // Anchored regex equivalent to glob, or false when it has no exact translation
+    static bool to_regex(const std::string& glob, std::string& regex);
+};
+
+} // namespace cpp_ripgrep
@@ -2,19 +2,32 @@
 
 #include "options.hpp"
 #include "regex_matcher.hpp"
+#include "regex_set_matcher.hpp"
 #include "re2_matcher.hpp"
+#include "re2_set_matcher.hpp"
 #include "file_scanner.hpp"
+#include "literal_searcher.hpp"
+#include "aho_corasick_matcher.hpp"
+#include "parallel_walker.hpp"
+#include "reorder_buffer.hpp"
+#include "uring_reader.hpp"
+#include "trigram_index.hpp"
+#include "output_sink.hpp"
+#include "json_writer.hpp"
+#include "search_sink.hpp"
+#include "worker_pool.hpp"
+#include <chrono>
+#include <condition_variable>
 #include <thread>
 #include <atomic>
 #include <mutex>
-#include <queue>
-#include <condition_variable>
 
 namespace cpp_ripgrep {
 
 struct SearchResult {
     std::string file_path;
     size_t line_number;
+    size_t byte_offset;          // of the line start within the file
     std::string line_content;
     std::vector<Match> matches;
     bool matched;
@@ -24,8 +37,25 @@ class GrepEngine {
 public:
     explicit GrepEngine(const Options& options);
     
-    // Main search function
+    // Check whether the patterns compiled; an invalid engine must not search
+    bool is_valid() const { return error_.empty(); }
+    std::string get_error() const { return error_; }
+    
+    // Main search function: prints results for options_.paths and returns
+    // the exit status
     int search();
+    
+    // Search paths and report every file and match to sink instead of
+    // printing. The compiled matchers and worker threads are kept between
+    // calls, so one engine serves any number of searches, one at a time.
+    // Files reach the sink in completion order; --sort-files does not apply.
+    SearchSummary search(const std::vector<std::string>& paths, SearchSink& sink);
+    
+    // Stop the search in progress; safe to call from any thread. The engine
+    // stays cancelled, so a search started afterwards returns at once,
+    // until reset_cancel() is called.
+    void cancel() { cancel_.cancel(); }
+    void reset_cancel() { cancel_.reset(); }
 
     // Start the search asynchronously
     void start_search();
@@ -33,50 +63,172 @@ public:
     // Stop the search and wait for workers
     void stop_search();
     
-    // Get results (for testing or programmatic use)
-    const std::vector<SearchResult>& get_results() const { return results_; }
-    
     // Get match count
     size_t get_match_count() const { return match_count_; }
 
 private:
     Options options_;
+    std::string error_;
+    std::unique_ptr<LiteralSearcher> literal_searcher_;
+    std::unique_ptr<AhoCorasickMatcher> multi_literal_matcher_;
     std::unique_ptr<RegexMatcher> pcre2_matcher_;
+    std::unique_ptr<RegexSetMatcher> pcre2_set_matcher_;
     std::unique_ptr<RE2Matcher> re2_matcher_;
+    std::unique_ptr<RE2SetMatcher> re2_set_matcher_;
     FileScanner scanner_;
     
-    std::vector<SearchResult> results_;
     std::atomic<size_t> match_count_{0};
     
+    // Statistics for --stats
+    std::atomic<size_t> files_searched_{0};
+    std::atomic<size_t> bytes_searched_{0};
+    std::atomic<size_t> split_files_{0};
+    std::atomic<size_t> split_chunks_{0};
+    std::atomic<size_t> index_skipped_{0};
+    
+    // Totals for the --json summary
+    std::atomic<size_t> matches_found_{0};
+    std::atomic<size_t> files_matched_{0};
+    
+    // --index: files the trigram query allows, by index file id
+    std::unique_ptr<TrigramIndex> index_;
+    std::vector<bool> index_candidates_;
+    
+    // Set by cancel() or on the first match with -q; stops the walk and
+    // every worker
+    CancellationToken cancel_;
+    std::atomic<bool> stopped_by_quiet_{false};
+    
+    // Files and directories reported to the sink as unreadable
+    std::atomic<size_t> errors_{0};
+    
     // Threading support
-    std::vector<std::thread> workers_;
-    std::queue<FileInfo> file_queue_;
-    std::mutex queue_mutex_;
-    std::mutex results_mutex_;
-    std::condition_variable queue_cv_;
-    std::atomic<bool> done_{false};
+    WorkerPool pool_;
+    std::unique_ptr<ParallelWalker> walker_;
+    
+    // Receiver of results for search(paths, sink); null when printing
+    SearchSink* sink_ = nullptr;
+    
+    // Standard output; workers hand it one formatted batch per file
+    OutputSink output_;
+    
+    // Whether to emit color codes, decided once from --color and the sink
+    bool use_color_ = false;
+    
+    // Whether a regex may anchor with '$', which the whole-buffer search
+    // cannot match before a CRLF ending
+    bool anchors_line_end_ = false;
+    
+    // Whether a regex uses \A, \z or \Z, which only mean the ends of a
+    // line when each line is searched as its own subject
+    bool anchors_subject_ = false;
+    
+    // Sorted output (--sort-files): files numbered in traversal order
+    struct OrderedFile {
+        const char* path = nullptr;
+        uint32_t length = 0;
+        size_t sequence = 0;
+    };
+    static constexpr size_t kReorderWindowPerThread = 16;
+    std::unique_ptr<ReorderBuffer> reorder_;
+    std::unique_ptr<MpmcQueue<OrderedFile>> ordered_files_;
+    PathArena ordered_paths_;
+    std::atomic<bool> walk_done_{false};
+    std::mutex ordered_mutex_;
+    std::condition_variable ordered_cv_;     // a file was queued or the walk ended
+    std::atomic<size_t> ordered_parked_{0};
     
-    // Worker thread function
-    void worker_thread();
+    // `index` subcommand: build or refresh the trigram index
+    int build_index();
+    void index_file(std::string_view path, TrigramIndexBuilder& builder, TrigramCollector& collector);
     
-    // Process a single file
-    void process_file(const FileInfo& file_info);
+    // Map the --index file and select candidate files for the patterns
+    void load_index();
     
-    // Search in file content
+    // Whether the index proves path cannot match; files that are not
+    // indexed or changed since are never skipped
+    bool skipped_by_index(std::string_view path);
+    
+    // Worker loop walking the tree with the other workers
+    void walk_worker(size_t worker);
+    
+    // Worker loop for sorted output
+    void ordered_worker();
+    void wake_ordered_worker();
+    
+    // Clear the counters left by an earlier search. A pending cancel() is
+    // kept: only reset_cancel() clears it.
+    void reset_search();
+    
+    // Worker loop for --io io_uring: reads are submitted ahead and files
+    // are searched as their reads complete
+    void uring_worker(size_t worker);
+    static constexpr unsigned kUringDepth = 32;
+    
+    // Read and search a single file and return its formatted output
+    std::string process_file(std::string_view path);
+    
+    // Search contents already read (or a stream for large files) and
+    // return the formatted output
+    std::string search_file(const std::string& file_path, FileBuffer buffer, ChunkReader* stream);
+    
+    // Whether large files may be searched in parallel pieces
+    bool can_split() const;
+    
+    void report_read_error(const std::string& file_path, const std::string& message);
+    
+    // Search in file content, stopping after max_lines results; first_line
+    // and first_offset are the line number and file offset where content starts
     std::vector<SearchResult> search_in_content(const std::string& file_path, 
-                                               const std::string& content);
+                                               std::string_view content,
+                                               size_t first_line, size_t first_offset,
+                                               size_t max_lines);
+    
+    // One large file being searched in pieces by several workers
+    struct SplitJob {
+        std::string_view content;
+        std::vector<size_t> boundaries;                  // piece i is [boundaries[i], boundaries[i + 1])
+        std::vector<std::vector<SearchResult>> results;  // per piece, line numbers piece-relative
+        std::vector<size_t> newlines;                    // per piece, for the line number prefix sum
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+    };
+    static constexpr size_t kMinSplitChunk = 4 * 1024 * 1024;
+    
+    // Search a buffer above the split threshold with help from idle workers
+    std::vector<SearchResult> search_in_parallel(const std::string& file_path,
+                                                 std::string_view content, size_t max_lines);
+    
+    // Whether results need line numbers at all
+    bool need_line_numbers() const;
+    
+    // Matching lines to report per file before stopping
+    size_t line_limit() const;
+    
+    // Find the next candidate match anywhere in the buffer at or after `from`
+    std::optional<MatchRange> find_next_match(std::string_view content, size_t from) const;
+    
+    // Check a single line (without its terminator) and collect its matches
+    bool match_line(std::string_view line, std::vector<Match>& matches) const;
+    
+    // Print --stats counters
+    void print_stats() const;
     
-    // Add result thread-safely
-    void add_result(const SearchResult& result);
+    // Append one result line (without its terminator) to out
+    void format_output(const SearchResult& result, std::string& out) const;
     
-    // Print result
-    void print_result(const SearchResult& result) const;
+    // --json: append one JSON Lines event per matching line, and the
+    // begin/end events that bracket a file's matches
+    void format_json(const SearchResult& result, std::string& out) const;
+    void format_json_begin(const std::string& file_path, std::string& out) const;
+    void format_json_end(const std::string& file_path, size_t matched_lines, size_t matches,
+                         size_t bytes_searched, std::string& out) const;
     
-    // Format output
-    std::string format_output(const SearchResult& result) const;
+    // --json: the summary event closing the output
+    void write_json_summary(std::chrono::steady_clock::duration elapsed);
     
-    // Color support
-    std::string colorize(const std::string& text, const std::string& color) const;
+    // Append text, wrapped in color_code when color is enabled
+    void append_colored(std::string& out, std::string_view text, const char* color_code) const;
 };
 
 } // namespace cpp_ripgrep
\ No newline at end of file
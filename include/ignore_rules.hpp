@@ -0,0 +1,57 @@
+#pragma once
+
+#include "glob.hpp"
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cpp_ripgrep {
+
+// Compiled .gitignore / .ignore rules of one directory, chained to the
+// rules inherited from its ancestors.
+//
+// Each directory's files are parsed once, when the directory is listed,
+// and the resulting set is shared by every subdirectory beneath it. A
+// path is decided by the innermost directory with a matching rule, and
+// within one directory the last matching rule wins (rules from .ignore
+// come after those from .gitignore), as in git.
+class IgnoreRules {
+public:
+    using Ptr = std::shared_ptr<const IgnoreRules>;
+
+    // Ignore file names looked for in every directory, in precedence order
+    static constexpr const char* kIgnoreFiles[] = {".gitignore", ".ignore"};
+
+    // Rules for `directory` given the names of the ignore files it holds;
+    // returns `parent` itself when none of them yields a rule
+    static Ptr load(const std::string& directory, const std::vector<std::string>& files, Ptr parent);
+
+    // Whether `path` (an entry somewhere below this set's directory, named
+    // the way the walker built it) is ignored
+    bool is_ignored(std::string_view path, bool is_directory) const;
+
+    size_t rule_count() const { return rules_.size(); }
+
+private:
+    struct Rule {
+        Glob glob;
+        bool negated = false;
+        bool directory_only = false;
+        bool anchored = false;    // match the relative path, not just the name
+    };
+
+    enum class Verdict { NONE, IGNORE, INCLUDE };
+
+    std::string base_;
+    std::vector<Rule> rules_;
+    Ptr parent_;
+
+    IgnoreRules(std::string base, Ptr parent) : base_(std::move(base)), parent_(std::move(parent)) {}
+
+    void add_file(const std::string& file_path);
+    void add_line(std::string_view line);
+    Verdict decide(std::string_view path, bool is_directory) const;
+};
+
+} // namespace cpp_ripgrep
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace cpp_ripgrep {
+
+// Minimal JSON serializer that appends straight into an output buffer.
+//
+// Commas are placed automatically; callers only open and close containers
+// and emit keys and values. Nothing is allocated beyond the growth of the
+// buffer itself. Keys are written verbatim and must need no escaping.
+class JsonWriter {
+public:
+    explicit JsonWriter(std::string& out) : out_(out) {}
+
+    void begin_object();
+    void end_object();
+    void begin_array();
+    void end_array();
+
+    void key(std::string_view name);
+
+    // A string known to be valid UTF-8, such as a field name used as a value
+    void string(std::string_view text);
+
+    void number(uint64_t value);
+    void null();
+
+    // Arbitrary bytes as {"text": "..."} when they are valid UTF-8, and as
+    // {"bytes": "<base64>"} otherwise, so no input is ever altered
+    void data(std::string_view bytes);
+
+private:
+    std::string& out_;
+    uint64_t has_items_ = 0;   // per nesting level, whether a comma is due
+    unsigned depth_ = 0;
+    bool after_key_ = false;
+
+    void separate();
+
+    // Append text as a quoted, escaped string; returns false, leaving out_
+    // unchanged, if text is not valid UTF-8
+    bool append_string(std::string_view text);
+
+    void append_base64(std::string_view bytes);
+};
+
+} // namespace cpp_ripgrep
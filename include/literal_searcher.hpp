@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace cpp_ripgrep {
+
+// Fast substring search for a fixed needle over large buffers.
+//
+// The two rarest bytes of the needle (ranked with a static byte-frequency
+// table) are compared against 16/32 candidate positions at a time with
+// packed SIMD compares; only positions where both bytes agree are verified
+// with memcmp. Typical needles therefore skip through text at close to
+// memory bandwidth.
+class LiteralSearcher {
+public:
+    explicit LiteralSearcher(std::string needle);
+
+    // Offset of the first occurrence at or after `from`, or npos
+    size_t find(std::string_view haystack, size_t from = 0) const;
+
+    // Offsets of all non-overlapping occurrences
+    std::vector<size_t> find_all(std::string_view haystack) const;
+
+    const std::string& needle() const { return needle_; }
+    size_t size() const { return needle_.size(); }
+
+    // Relative frequency rank of a byte in typical text (0 = rarest, 255 = most common)
+    static uint8_t byte_rank(unsigned char byte);
+
+    static constexpr size_t npos = std::string_view::npos;
+
+private:
+    std::string needle_;
+    size_t rare1_index_ = 0;
+    size_t rare2_index_ = 0;
+
+    size_t find_scalar(const char* haystack, size_t size, size_t from) const;
+};
+
+} // namespace cpp_ripgrep
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "file_buffer.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace cpp_ripgrep {
+
+// What identifies one version of a file: where it lives and when and how
+// it was last written
+struct FileIdentity {
+    uint64_t device = 0;
+    uint64_t inode = 0;
+    int64_t mtime = 0;   // nanoseconds
+    uint64_t size = 0;
+};
+
+// On-disk cache of per-file facts that would otherwise be re-derived on
+// every run, keyed by device and inode and valid while mtime and size
+// match.
+//
+// The file is a header followed by entries sorted by (device, inode); it
+// is mapped read-only and searched in place, so lookups from any thread
+// take no lock. Facts learned during the run are collected separately and
+// merged into a new file by save(), which writes nothing when no entry
+// changed, so repeated runs over an unchanged tree only read the cache.
+class MetadataCache {
+public:
+    enum class Kind : uint32_t {
+        UNKNOWN = 0,
+        TEXT = 1,
+        BINARY = 2    // NUL byte in the first block
+    };
+
+    // Map the cache at path; a missing file gives an empty cache, and an
+    // unreadable one an empty cache plus a warning
+    static std::unique_ptr<MetadataCache> open(const std::string& path);
+
+    ~MetadataCache();
+
+    // Disable copy
+    MetadataCache(const MetadataCache&) = delete;
+    MetadataCache& operator=(const MetadataCache&) = delete;
+
+    Kind lookup(const FileIdentity& identity) const;
+
+    // Remember what was learned about a file in this run
+    void record(const FileIdentity& identity, Kind kind);
+
+    // Write the merged cache back if anything changed
+    bool save(std::string& error);
+
+    // Files skipped without being read because the cache knew them binary
+    size_t binary_skips() const { return binary_skips_.load(std::memory_order_relaxed); }
+    void count_binary_skip() const { binary_skips_.fetch_add(1, std::memory_order_relaxed); }
+
+    struct Entry {
+        uint64_t device;
+        uint64_t inode;
+        int64_t mtime;
+        uint64_t size;
+        uint32_t kind;
+        uint32_t reserved;
+    };
+
+private:
+    std::string path_;
+    FileBuffer data_;
+    const Entry* entries_ = nullptr;     // into data_, or saved_ once saved
+    size_t count_ = 0;
+    std::vector<Entry> saved_;
+
+    std::mutex mutex_;
+    std::vector<Entry> recorded_;
+    mutable std::atomic<size_t> binary_skips_{0};
+
+    explicit MetadataCache(std::string path) : path_(std::move(path)) {}
+
+    const Entry* find(uint64_t device, uint64_t inode) const;
+};
+
+} // namespace cpp_ripgrep
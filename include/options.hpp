@@ -8,6 +8,7 @@ namespace cpp_ripgrep {
 
 enum class SearchMode {
     LITERAL,
+    MULTI_LITERAL,
     REGEX,
     CASE_INSENSITIVE
 };
@@ -17,15 +18,26 @@ enum class RegexEngine {
     RE2
 };
 
+enum class IoBackend {
+    MMAP,       // map each file
+    PREAD,      // read each file into memory
+    IO_URING    // keep many opens and reads in flight with io_uring (Linux)
+};
+
 struct Options {
-    std::string pattern;
+    std::string pattern;                 // single pattern, or alternation of all patterns
+    std::vector<std::string> patterns;   // every pattern from PATTERN, -e and -f
     std::vector<std::string> paths;
     SearchMode mode = SearchMode::LITERAL;
     RegexEngine regex_engine = RegexEngine::PCRE2;
+    IoBackend io_backend = IoBackend::MMAP;
     bool recursive = true;
     bool ignore_case = false;
+    bool fixed_strings = false;          // patterns are literal strings, not regexes
     bool line_number = false;
     bool count_only = false;
+    bool files_with_matches = false;
+    int max_count = -1;                  // matching lines per file, -1 means no limit
     bool invert_match = false;
     bool word_match = false;
     bool line_match = false;
@@ -33,20 +45,38 @@ struct Options {
     int threads = 0; // 0 means auto-detect
     std::vector<std::string> exclude_patterns;
     std::vector<std::string> include_patterns;
+    bool no_ignore = false;              // don't honor .gitignore / .ignore files
     bool quiet = false;
     bool show_filename = true;
     bool show_line_number = true;
+    bool show_pattern_index = false;
+    bool stop_at_nul = false;            // end each file at its first NUL byte
+    bool search_zip = false;             // search inside gzip files
+    bool sort_files = false;             // print files in sorted traversal order
+    size_t split_threshold = 64 * 1024 * 1024; // search larger files in parallel pieces, 0 disables
+    bool stats = false;
+    bool json = false;                   // one JSON object per line instead of text
+    bool build_index = false;            // `index` subcommand: build or refresh the index
+    std::string index_path;              // trigram index to build, or to consult while searching
+    std::string cache_path;              // file metadata cache, empty for none
     std::optional<std::string> color = std::nullopt;
 };
 
 class OptionsParser {
 public:
+    // Where `index` writes when no --index is given
+    static constexpr const char* kDefaultIndexPath = ".cpp_ripgrep.idx";
+
     static Options parse(int argc, char* argv[]);
     static void print_usage(const char* program_name);
     static void print_version();
 
+    // Byte count with an optional K, M or G suffix
+    static size_t parse_size(const std::string& value);
+
 private:
     static void validate_options(const Options& options);
+    static void read_pattern_file(const std::string& path, std::vector<std::string>& patterns);
 };
 
 } // namespace cpp_ripgrep 
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace cpp_ripgrep {
+
+// Destination for search output, written with write(2) rather than
+// through iostreams.
+//
+// Workers format each file's lines into their own byte buffer and hand the
+// whole batch over in one call, so batches never interleave. When output
+// goes to a pipe or file, batches are coalesced into one large buffer and
+// written when it fills; on a terminal each batch is written at once so
+// results appear as they are found. Whether the descriptor is a terminal
+// is decided once, at construction.
+class OutputSink {
+public:
+    static constexpr size_t kBufferSize = 256 * 1024;
+
+    explicit OutputSink(int fd);
+    ~OutputSink();
+
+    // Disable copy
+    OutputSink(const OutputSink&) = delete;
+    OutputSink& operator=(const OutputSink&) = delete;
+
+    bool is_terminal() const { return terminal_; }
+
+    // Write bytes contiguously; safe to call from any thread
+    void write(std::string_view bytes);
+
+    // Write out anything still buffered
+    void flush();
+
+private:
+    int fd_;
+    bool terminal_;
+    bool failed_ = false;   // e.g. the reader of a pipe went away
+    std::mutex mutex_;
+    std::string buffer_;
+
+    void write_fd(const char* data, size_t size);
+};
+
+} // namespace cpp_ripgrep
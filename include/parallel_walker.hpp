@@ -0,0 +1,108 @@
+#pragma once
+
+#include "cancellation_token.hpp"
+#include "file_scanner.hpp"
+#include "mpmc_queue.hpp"
+#include "path_arena.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Forward declaration
+namespace cpp_ripgrep {
+    struct Options;
+}
+
+namespace cpp_ripgrep {
+
+// Work-stealing directory walker.
+//
+// Directories live in per-worker deques: a worker takes work from the back
+// of its own deque (depth first, for locality) and, when that runs dry,
+// steals from the front of a peer's deque, where the larger unexplored
+// subtrees sit. Files found while listing go into one bounded lock-free
+// ring shared by all workers, as compact pointers into per-worker path
+// arenas, so handing a file to another thread copies no strings and takes
+// no lock. A count of queued-but-unfinished items detects quiescence: once
+// it reaches zero nothing can produce more work and every worker returns.
+class ParallelWalker {
+public:
+    ParallelWalker(const FileScanner& scanner, const Options& options, size_t num_workers,
+                   const CancellationToken& cancel);
+
+    // Queue the root paths before any worker starts
+    void seed(const std::vector<std::string>& paths);
+
+    // Body of worker thread `worker`; calls file_callback for every file to
+    // search and returns once the whole tree has been walked or the search
+    // is cancelled. idle_callback, if given, runs whenever the queues are
+    // empty and returns whether it did any work (e.g. finishing reads the
+    // worker still has in flight) before the worker spins or parks.
+    void work(size_t worker, const std::function<void(std::string_view)>& file_callback,
+              const std::function<bool()>& idle_callback = nullptr);
+
+    // Queue an arbitrary task, e.g. a piece of a large file, for whichever
+    // worker gets to it first. Tasks are spread over the workers' deques.
+    void spawn(std::function<void()> task);
+
+private:
+    // Directory to list, a file given on the command line, or a spawned task
+    struct WalkItem {
+        std::string path;
+        int depth = 0;
+        bool is_directory = false;
+        IgnoreRules::Ptr ignore;   // rules inherited from the ancestors
+        std::function<void()> task;
+    };
+
+    // File found while walking; path points into the finder's arena
+    struct FileItem {
+        const char* path = nullptr;
+        uint32_t length = 0;
+    };
+
+    struct alignas(64) WorkerQueue {
+        std::mutex mutex;
+        std::deque<WalkItem> items;
+        PathArena arena;   // written only by the owning worker
+    };
+
+    // Iterations a worker spins on empty queues before it parks
+    static constexpr unsigned kSpinRounds = 64;
+    static constexpr size_t kFileQueueCapacity = 4096;
+
+    const FileScanner& scanner_;
+    const Options& options_;
+    const CancellationToken& cancel_;
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    MpmcQueue<FileItem> files_;
+    std::atomic<size_t> pending_{0};
+    std::atomic<size_t> next_spawn_{0};
+
+    // Parking for idle workers; only touched once spinning has failed
+    std::mutex park_mutex_;
+    std::condition_variable park_cv_;
+    std::atomic<size_t> parked_{0};
+
+    void push(size_t worker, WalkItem item);
+    bool pop(size_t worker, WalkItem& item);
+    bool steal(size_t thief, WalkItem& item);
+    void expand_directory(size_t worker, const WalkItem& directory,
+                          const std::function<void(std::string_view)>& file_callback);
+
+    // Mark one item done, waking everyone when it was the last
+    void finish_item();
+    bool has_work();
+    void park();
+    void wake_one();
+    void wake_all();
+};
+
+} // namespace cpp_ripgrep
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace cpp_ripgrep {
+
+// Append-only storage for path strings.
+//
+// Paths are copied into large blocks that are never moved or freed before
+// the arena itself, so a pointer handed out stays valid for the whole
+// search and can be passed between threads instead of a std::string. An
+// arena has a single writer; readers only ever follow pointers it returned.
+class PathArena {
+public:
+    PathArena() = default;
+
+    // Disable copy
+    PathArena(const PathArena&) = delete;
+    PathArena& operator=(const PathArena&) = delete;
+
+    // Copy path into the arena; the copy is NUL-terminated
+    const char* store(std::string_view path);
+
+    // Bytes handed out so far
+    size_t used() const { return used_; }
+
+    // Release every stored path; earlier pointers become invalid
+    void clear();
+
+private:
+    static constexpr size_t kBlockSize = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    char* cursor_ = nullptr;
+    size_t remaining_ = 0;
+    size_t used_ = 0;
+};
+
+} // namespace cpp_ripgrep
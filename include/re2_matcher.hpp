@@ -1,6 +1,8 @@
 #pragma once
 
 #include "common.hpp"
+#include "regex_prefilter.hpp"
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <optional>
@@ -29,22 +31,29 @@ public:
     std::string get_error() const { return error_; }
 
     // Find all matches in a string
-    std::vector<Match> find_all(const std::string& text) const;
+    std::vector<Match> find_all(std::string_view text) const;
     
     // Check if string matches pattern
-    bool matches(const std::string& text) const;
+    bool matches(std::string_view text) const;
     
     // Find first match
-    std::optional<Match> find_first(const std::string& text) const;
+    std::optional<Match> find_first(std::string_view text) const;
+
+    // Find the next match at or after start_offset, e.g. across a whole file buffer
+    std::optional<MatchRange> find_next(std::string_view text, size_t start_offset) const;
 
 private:
 #ifdef HAVE_RE2
     std::unique_ptr<re2::RE2> regex_;
 #endif
+    std::unique_ptr<RegexPrefilter> prefilter_;
     std::string error_;
     std::string pattern_;
     bool case_insensitive_;
     
+    // Unfiltered search of text from start_offset
+    std::optional<MatchRange> search_from(std::string_view text, size_t start_offset) const;
+    
     void cleanup();
     void move_from(RE2Matcher&& other);
 };
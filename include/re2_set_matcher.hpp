@@ -0,0 +1,84 @@
+#pragma once
+
+#include "common.hpp"
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <optional>
+
+#ifdef HAVE_RE2
+#include <re2/re2.h>
+#include <re2/set.h>
+#endif
+
+namespace cpp_ripgrep {
+
+// Multi-regex matcher for rule sets, built on re2::RE2::Set.
+//
+// A single DFA pass over the input reports which rules fire at all; only
+// those rules are then run individually to locate their matches. Matches
+// carry the index of the rule that produced them.
+class RE2SetMatcher {
+public:
+    explicit RE2SetMatcher(const std::vector<std::string>& patterns, bool case_insensitive = false);
+    ~RE2SetMatcher();
+
+    // Disable copy
+    RE2SetMatcher(const RE2SetMatcher&) = delete;
+    RE2SetMatcher& operator=(const RE2SetMatcher&) = delete;
+
+    // Check if every rule compiled
+    bool is_valid() const { return error_.empty(); }
+    std::string get_error() const { return error_; }
+
+    // Indices of the rules with at least one match in text
+    std::vector<int> matching_rules(std::string_view text) const;
+
+    // Find all non-overlapping matches of the rules that fire in a string
+    std::vector<Match> find_all(std::string_view text) const;
+
+    // Check if some rule matches the whole string
+    bool matches(std::string_view text) const;
+
+    // Find first match
+    std::optional<Match> find_first(std::string_view text) const;
+
+    size_t rule_count() const;
+
+    // Incremental search of one buffer. The set runs once up front; each
+    // fired rule then scans forward from where it last matched, so a whole
+    // file costs one DFA pass plus one pass per rule that actually fires.
+    class Cursor {
+    public:
+        // Next match at or after `from`; `from` must not decrease between calls
+        std::optional<MatchRange> next(size_t from);
+
+    private:
+        friend class RE2SetMatcher;
+
+        struct Pending {
+            int rule;
+            bool searched;
+            MatchRange range;
+        };
+
+        Cursor(const RE2SetMatcher& matcher, std::string_view text, std::vector<int> rules);
+
+        const RE2SetMatcher* matcher_;
+        std::string_view text_;
+        std::vector<Pending> pending_;
+    };
+
+    Cursor scan(std::string_view text) const;
+
+private:
+#ifdef HAVE_RE2
+    std::unique_ptr<re2::RE2::Set> set_;
+    std::vector<std::unique_ptr<re2::RE2>> rules_;
+#endif
+    std::string error_;
+
+    std::optional<MatchRange> find_rule(int rule, std::string_view text, size_t start_offset) const;
+};
+
+} // namespace cpp_ripgrep
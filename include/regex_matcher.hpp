@@ -1,9 +1,12 @@
 #pragma once
 
 #include "common.hpp"
+#include "regex_prefilter.hpp"
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <optional>
+#include <cstdint>
 
 #ifdef HAVE_PCRE2
 // Define PCRE2 code unit width before including pcre2.h
@@ -36,25 +39,54 @@ public:
     }
     std::string get_error() const { return error_; }
 
+    // Whether matching runs through the PCRE2 JIT rather than the interpreter
+    bool is_jit_compiled() const { return jit_compiled_; }
+
     // Find all matches in a string
-    std::vector<Match> find_all(const std::string& text) const;
+    std::vector<Match> find_all(std::string_view text) const;
     
     // Check if string matches pattern
-    bool matches(const std::string& text) const;
+    bool matches(std::string_view text) const;
     
     // Find first match
-    std::optional<Match> find_first(const std::string& text) const;
+    std::optional<Match> find_first(std::string_view text) const;
+
+    // Find the next match at or after start_offset, e.g. across a whole file buffer
+    std::optional<MatchRange> find_next(std::string_view text, size_t start_offset) const;
 
     // Literal string matching (for performance when regex not needed)
-    static bool literal_match(const std::string& text, const std::string& pattern, bool case_insensitive = false);
+    static bool literal_match(std::string_view text, std::string_view pattern, bool case_insensitive = false);
+
+    // Join patterns[begin, end) into one alternation whose alternatives carry
+    // (*MARK:n) tags, so find_all reports which pattern matched in
+    // Match::pattern_index; n is the index into the whole vector
+    static std::string tagged_alternation(const std::vector<std::string>& patterns,
+                                          size_t begin = 0, size_t end = SIZE_MAX);
 
 private:
+    // Per-thread match data, match context and JIT stack for one matcher
+    struct MatchScratch;
+
+    // Pattern index from the (*MARK:n) tag of the last match, or 0
+    static size_t marked_pattern(const MatchScratch* scratch);
+
 #ifdef HAVE_PCRE2
     pcre2_code* code_;
-    pcre2_match_data* match_data_;
 #endif
+    uint64_t id_ = 0;
+    bool jit_compiled_ = false;
+    std::unique_ptr<RegexPrefilter> prefilter_;
     std::string error_;
     
+    // Unfiltered search of text from start_offset
+    std::optional<MatchRange> search_from(std::string_view text, size_t start_offset) const;
+
+    // Scratch space of the calling thread, created on first use
+    MatchScratch* scratch() const;
+
+    // Run one match attempt; returns the PCRE2 result code
+    int run_match(std::string_view text, size_t start_offset, uint32_t options, MatchScratch* scratch) const;
+    
     void cleanup();
     void move_from(RegexMatcher&& other);
 };
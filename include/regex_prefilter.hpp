@@ -0,0 +1,39 @@
+#pragma once
+
+#include "literal_searcher.hpp"
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cpp_ripgrep {
+
+// Literal prefilter for regex searches.
+//
+// A conservative syntax pass (shared by the PCRE2 and RE2 matchers) finds
+// literal factors that every match of the pattern must contain, e.g.
+// "ERROR" in `ERROR\s+\d+` or "foo"/"bar" in `foo.*bar`. The rarest factor
+// is then located with LiteralSearcher and the regex engine only runs on
+// the lines around those hits.
+class RegexPrefilter {
+public:
+    // Prefilter for pattern, or nullptr when no required literal is known
+    static std::unique_ptr<RegexPrefilter> build(const std::string& pattern, bool case_insensitive = false);
+
+    // Literal factors that every match must contain (empty if none can be proven)
+    static std::vector<std::string> required_literals(const std::string& pattern);
+
+    // Next line at or after `from` that contains the literal, as the range
+    // [line_start, line_end) without its '\n'. `from` must be a line start.
+    bool next_candidate_line(std::string_view text, size_t from,
+                             size_t& line_start, size_t& line_end) const;
+
+    const std::string& literal() const { return searcher_.needle(); }
+
+private:
+    explicit RegexPrefilter(std::string literal);
+
+    LiteralSearcher searcher_;
+};
+
+} // namespace cpp_ripgrep
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "common.hpp"
+#include "regex_matcher.hpp"
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <optional>
+
+namespace cpp_ripgrep {
+
+// PCRE2 matcher for pattern sets too large for one compiled program.
+//
+// A tagged alternation of every pattern stops compiling at 64 KiB of
+// compiled code, around a thousand host names. The patterns are split into
+// consecutive groups, each compiled as its own tagged alternation, and the
+// programs' matches are merged. Matches carry the index of the pattern that
+// produced them, as with a single tagged RegexMatcher.
+class RegexSetMatcher {
+public:
+    explicit RegexSetMatcher(const std::vector<std::string>& patterns, bool case_insensitive = false);
+
+    // Disable copy
+    RegexSetMatcher(const RegexSetMatcher&) = delete;
+    RegexSetMatcher& operator=(const RegexSetMatcher&) = delete;
+
+    // Check if every pattern compiled
+    bool is_valid() const { return error_.empty(); }
+    std::string get_error() const { return error_; }
+
+    // Find all non-overlapping matches in a string, leftmost first and the
+    // lowest pattern index among matches at the same start
+    std::vector<Match> find_all(std::string_view text) const;
+
+    // Check if some pattern matches the whole string
+    bool matches(std::string_view text) const;
+
+    // Find the next match at or after start_offset
+    std::optional<MatchRange> find_next(std::string_view text, size_t start_offset) const;
+
+    size_t program_count() const { return programs_.size(); }
+
+    // Incremental search of one buffer. Each program keeps its next match
+    // and only searches again once the caller has moved past it, so a whole
+    // file costs one pass per program rather than one per candidate line.
+    class Cursor {
+    public:
+        // Next match at or after `from`; `from` must not decrease between calls
+        std::optional<MatchRange> next(size_t from);
+
+    private:
+        friend class RegexSetMatcher;
+
+        struct Pending {
+            const RegexMatcher* program;
+            bool searched;
+            MatchRange range;
+        };
+
+        Cursor(const RegexSetMatcher& matcher, std::string_view text);
+
+        std::string_view text_;
+        std::vector<Pending> pending_;
+    };
+
+    Cursor scan(std::string_view text) const;
+
+private:
+    std::vector<std::unique_ptr<RegexMatcher>> programs_;
+    std::string error_;
+
+    // Compile patterns[begin, end) as one program, halving the range until
+    // the pieces fit; false once a single pattern fails on its own
+    bool compile_group(const std::vector<std::string>& patterns, size_t begin, size_t end,
+                       bool case_insensitive);
+};
+
+} // namespace cpp_ripgrep
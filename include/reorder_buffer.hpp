@@ -0,0 +1,39 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace cpp_ripgrep {
+
+// Restores sequence order for output batches that complete out of order.
+//
+// Every searched file gets a sequence number in traversal order and submits
+// exactly one batch (possibly empty). A batch is emitted as soon as all
+// earlier ones have been; later ones wait in a map. The producer of sequence
+// numbers calls wait_for_slot first, which keeps at most `window` batches
+// between the oldest unfinished file and the newest dispatched one, so the
+// memory held here is bounded by the files in flight.
+class ReorderBuffer {
+public:
+    ReorderBuffer(std::function<void(const std::string&)> emit, size_t window);
+
+    // Block until `sequence` is within the window of the next batch to emit
+    void wait_for_slot(size_t sequence);
+
+    // Hand in the output of `sequence`; emits every batch that is now in order
+    void submit(size_t sequence, std::string batch);
+
+private:
+    std::function<void(const std::string&)> emit_;
+    size_t window_;
+    size_t next_ = 0;
+    std::map<size_t, std::string> pending_;
+    std::mutex mutex_;
+    std::condition_variable slot_cv_;
+};
+
+} // namespace cpp_ripgrep
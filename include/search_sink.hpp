@@ -0,0 +1,72 @@
+#pragma once
+
+#include "common.hpp"
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace cpp_ripgrep {
+
+// One matching line (or, with -v, non-matching line) handed to a sink.
+// The views are only valid for the duration of the call.
+struct SinkMatch {
+    std::string_view path;
+    std::string_view line;              // without its terminator
+    size_t line_number;                 // 0 when line numbers are off
+    size_t byte_offset;                 // of the line start within the file
+    const std::vector<Match>& matches;  // spans relative to line, empty with -v
+};
+
+// Counters for one searched file
+struct FileSearchStats {
+    size_t matched_lines = 0;
+    size_t matches = 0;
+    size_t bytes_searched = 0;
+};
+
+// Counters for a whole search
+struct SearchSummary {
+    size_t files_searched = 0;
+    size_t files_matched = 0;
+    size_t matched_lines = 0;
+    size_t matches = 0;
+    size_t bytes_searched = 0;
+    size_t errors = 0;        // reports to SearchSink::error, including an invalid pattern
+    bool cancelled = false;   // stopped by GrepEngine::cancel()
+};
+
+// Receiver of search results for programs embedding the engine.
+//
+// Every file that is read is reported as begin_file, its matches in file
+// order, then end_file, all from one worker thread. Different files are
+// reported concurrently from several workers, so implementations must be
+// safe to call for different paths at the same time.
+class SearchSink {
+public:
+    virtual ~SearchSink() = default;
+
+    virtual void begin_file(std::string_view path) { (void)path; }
+
+    virtual void match(const SinkMatch& match) = 0;
+
+    virtual void end_file(std::string_view path, const FileSearchStats& stats) {
+        (void)path;
+        (void)stats;
+    }
+
+    // A file or directory that could not be read; the search goes on.
+    // A pattern that did not compile is reported with an empty path.
+    virtual void error(std::string_view path, std::string_view message) {
+        (void)path;
+        (void)message;
+    }
+
+    // A path passed over without being an error, such as a root that
+    // does not exist, or a cache or index that could not be used
+    virtual void warning(std::string_view path, std::string_view message) {
+        (void)path;
+        (void)message;
+    }
+};
+
+} // namespace cpp_ripgrep
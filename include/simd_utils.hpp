@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CPP_RIPGREP_X86_DISPATCH 1
+#endif
+
+namespace cpp_ripgrep {
+
+// Byte-scanning primitives for the search hot loops. Each function picks
+// the widest implementation the running CPU supports (AVX2, SSE2 or a
+// portable scalar loop) the first time it is called.
+namespace simd {
+
+enum class Level {
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+// Widest instruction set usable on this CPU, detected once
+Level cpu_level();
+
+// Count occurrences of `byte` in `text`
+size_t count_byte(std::string_view text, char byte);
+
+// Count line terminators in `text`
+inline size_t count_newlines(std::string_view text) {
+    return count_byte(text, '\n');
+}
+
+// Offset of the first byte at or after `from` equal to any of `bytes`
+// (at most three), or std::string_view::npos
+size_t find_any_of(std::string_view text, size_t from, std::string_view bytes);
+
+// Name of the implementation selected for this CPU ("avx2", "sse2", "scalar")
+const char* implementation_name();
+
+} // namespace simd
+
+} // namespace cpp_ripgrep
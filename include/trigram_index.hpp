@@ -0,0 +1,155 @@
+#pragma once
+
+#include "file_buffer.hpp"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Forward declaration
+namespace cpp_ripgrep {
+    struct Options;
+}
+
+namespace cpp_ripgrep {
+
+// Size and modification time that decide whether an indexed file is current
+struct FileStamp {
+    uint64_t size = 0;
+    int64_t mtime = 0;   // nanoseconds
+
+    bool operator==(const FileStamp& other) const { return size == other.size && mtime == other.mtime; }
+
+    static std::optional<FileStamp> of(const std::string& path);
+};
+
+// Trigrams that every matching file must contain, as alternatives: a file
+// is a candidate when it holds all trigrams of at least one alternative.
+// match_all means the patterns give no usable trigram.
+struct TrigramQuery {
+    bool match_all = true;
+    std::vector<std::vector<uint32_t>> alternatives;
+
+    // Plan a query for the search described by options
+    static TrigramQuery plan(const Options& options);
+};
+
+// On-disk trigram index, mapped read-only.
+//
+// Layout (native byte order, every section 8-byte aligned):
+//   header
+//   file table     one entry per file: path, size, mtime
+//   path order     file ids sorted by path, for lookups
+//   strings        the paths
+//   trigram table  sorted by trigram: posting count and offset
+//   postings       per trigram, ascending file ids as varint deltas
+//
+// Trigrams are taken over ASCII-lowercased bytes and never span a line
+// break, since matches never do either.
+class TrigramIndex {
+public:
+    static constexpr uint32_t kNoFile = UINT32_MAX;
+
+    // Map an index file; returns nullptr and sets error on failure
+    static std::unique_ptr<TrigramIndex> open(const std::string& path, std::string& error);
+
+    size_t file_count() const;
+
+    // Id of the file indexed under path, or kNoFile
+    uint32_t find(std::string_view path) const;
+
+    std::string_view path(uint32_t id) const;
+    FileStamp stamp(uint32_t id) const;
+
+    // Ascending ids of the files containing trigram
+    std::vector<uint32_t> postings(uint32_t trigram) const;
+
+    // Per file id, whether the file may match the query
+    std::vector<bool> candidates(const TrigramQuery& query) const;
+
+    // Pack three bytes as a trigram, lowercasing ASCII letters
+    static uint32_t make_trigram(unsigned char a, unsigned char b, unsigned char c);
+
+    // Normalized form under which paths are indexed ("./" prefixes dropped)
+    static std::string_view normalize_path(std::string_view path);
+
+    struct Header;
+    struct FileEntry;
+    struct TrigramEntry;
+
+private:
+    friend class TrigramIndexBuilder;
+
+    FileBuffer data_;
+    const Header* header_ = nullptr;
+    const FileEntry* files_ = nullptr;
+    const uint32_t* order_ = nullptr;
+    const char* strings_ = nullptr;
+    const TrigramEntry* trigrams_ = nullptr;
+    const unsigned char* postings_ = nullptr;
+
+    TrigramIndex() = default;
+    bool validate(std::string& error);
+};
+
+// Distinct trigrams of one file's contents. Reused across files by a
+// worker; the bitmap makes adding a trigram a single bit test.
+class TrigramCollector {
+public:
+    TrigramCollector();
+
+    void add(std::string_view text);
+
+    // Trigrams seen since the last take, sorted; resets the collector
+    std::vector<uint32_t> take();
+
+private:
+    std::vector<uint64_t> seen_;
+    std::vector<uint32_t> found_;
+};
+
+// Builds a new index, reusing the trigrams of files that did not change
+// since the previous index. Files may be added from several threads.
+class TrigramIndexBuilder {
+public:
+    explicit TrigramIndexBuilder(const TrigramIndex* previous);
+
+    // Keep the previous index's entry for path if its stamp still matches
+    bool reuse(std::string_view path, const FileStamp& stamp);
+
+    // Add a file read from disk
+    void add(std::string_view path, const FileStamp& stamp, const std::vector<uint32_t>& trigrams);
+
+    size_t reused_count() const { return reused_.size(); }
+    size_t added_count() const { return added_.size(); }
+
+    // Write the index to path (through a temporary file and a rename)
+    bool write(const std::string& path, std::string& error);
+
+private:
+    struct AddedFile {
+        std::string path;
+        FileStamp stamp;
+    };
+
+    // Posting list of one trigram for the added files, varint deltas of
+    // their ids in order of addition
+    struct Postings {
+        std::string bytes;
+        uint32_t count = 0;
+        uint32_t first = 0;
+        uint32_t last = 0;
+    };
+
+    const TrigramIndex* previous_;
+    std::mutex mutex_;
+    std::vector<uint32_t> reused_;                 // previous ids
+    std::vector<AddedFile> added_;
+    std::unordered_map<uint32_t, Postings> postings_;
+};
+
+} // namespace cpp_ripgrep
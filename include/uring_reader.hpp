@@ -0,0 +1,104 @@
+#pragma once
+
+#include "file_buffer.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define CPP_RIPGREP_IO_URING 1
+#endif
+#endif
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace cpp_ripgrep {
+
+// Whole-file reader on Linux io_uring, used through raw system calls so no
+// liburing is needed.
+//
+// Each file goes through openat and statx (submitted together), then one or
+// more reads into a buffer of the file's size. Up to `depth` files are in
+// flight at once, so a worker keeps the device busy while it searches the
+// files that have already arrived. A reader belongs to one thread.
+class UringReader {
+public:
+    struct Completed {
+        std::string path;
+        FileBuffer contents;
+        int error = 0;            // errno of the failed step, 0 on success
+        bool too_large = false;   // above max_size; not read, caller falls back
+    };
+
+    UringReader(unsigned depth, size_t max_size);
+    ~UringReader();
+
+    // Disable copy
+    UringReader(const UringReader&) = delete;
+    UringReader& operator=(const UringReader&) = delete;
+
+    // Whether this kernel (and seccomp policy) allows io_uring; probed once
+    static bool available();
+
+    bool is_valid() const { return ring_fd_ >= 0; }
+
+    // Start reading path; false when `depth` files are already in flight
+    bool submit(std::string path);
+
+    size_t in_flight() const { return in_flight_; }
+
+    // Append finished files to `done`. With `wait`, blocks until at least
+    // one finishes (if any are in flight).
+    void reap(std::vector<Completed>& done, bool wait);
+
+private:
+#ifdef CPP_RIPGREP_IO_URING
+    enum Op : uint64_t { OPEN = 0, STAT = 1, READ = 2 };
+
+    struct Request {
+        std::string path;
+        int fd = -1;
+        alignas(8) unsigned char stat[256];   // struct statx, filled by the kernel
+        std::string data;
+        size_t filled = 0;
+        int error = 0;
+        unsigned outstanding = 0;   // operations still queued in the ring
+        bool active = false;
+    };
+
+    int ring_fd_ = -1;
+    void* sq_ring_ = nullptr;
+    void* cq_ring_ = nullptr;
+    size_t sq_ring_size_ = 0;
+    size_t cq_ring_size_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+
+    unsigned* sq_head_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_mask_ = nullptr;
+    unsigned* sq_array_ = nullptr;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned* cq_mask_ = nullptr;
+    io_uring_cqe* cqes_ = nullptr;
+    unsigned to_submit_ = 0;
+
+    std::vector<Request> requests_;
+    std::vector<size_t> free_slots_;
+
+    io_uring_sqe* next_sqe();
+    void queue_read(size_t slot);
+    void complete(size_t slot, Op op, int result, std::vector<Completed>& done);
+    void finish(size_t slot, std::vector<Completed>& done, bool too_large = false);
+#else
+    int ring_fd_ = -1;
+#endif
+    size_t max_size_;
+    size_t in_flight_ = 0;
+};
+
+} // namespace cpp_ripgrep
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cpp_ripgrep {
+
+// Fixed set of worker threads that outlive a single search.
+//
+// Every job runs once on each thread, which receives its index, so the
+// threads can play the same per-worker roles as the walker expects. The
+// threads are started with the first job and park between jobs, so an
+// engine that serves many searches creates them only once.
+class WorkerPool {
+public:
+    explicit WorkerPool(size_t num_threads);
+    ~WorkerPool();
+
+    // Disable copy
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    size_t size() const { return num_threads_; }
+
+    // Run job(i) on every thread i and return without waiting; the
+    // previous job must have been waited for
+    void start(std::function<void(size_t)> job);
+
+    // Block until every thread has finished the current job, if any
+    void wait();
+
+private:
+    size_t num_threads_;
+    std::vector<std::thread> threads_;
+    std::function<void(size_t)> job_;
+    size_t generation_ = 0;   // bumped for every job
+    size_t running_ = 0;      // threads still inside the current job
+    bool stopping_ = false;
+    std::mutex mutex_;
+    std::condition_variable job_cv_;
+    std::condition_variable done_cv_;
+
+    void thread_main(size_t index);
+};
+
+} // namespace cpp_ripgrep
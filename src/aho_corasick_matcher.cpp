@@ -0,0 +1,212 @@
+#include "aho_corasick_matcher.hpp"
+#include "simd_utils.hpp"
+#include <algorithm>
+#include <cctype>
+#include <queue>
+
+namespace cpp_ripgrep {
+
+namespace {
+
+unsigned char fold(unsigned char byte, bool case_insensitive) {
+    return case_insensitive ? static_cast<unsigned char>(std::tolower(byte)) : byte;
+}
+
+} // namespace
+
+AhoCorasickMatcher::AhoCorasickMatcher(const std::vector<std::string>& patterns, bool case_insensitive)
+    : patterns_(patterns), case_insensitive_(case_insensitive) {
+
+    if (patterns_.empty()) {
+        error_ = "No patterns given";
+        return;
+    }
+    for (const auto& pattern : patterns_) {
+        if (pattern.empty()) {
+            error_ = "Empty patterns are not supported";
+            return;
+        }
+    }
+
+    build();
+}
+
+void AhoCorasickMatcher::build() {
+    // Assign one class per distinct (case-folded) pattern byte; class 0 is
+    // shared by every byte that appears in no pattern
+    std::fill(std::begin(byte_class_), std::end(byte_class_), 0);
+    stride_ = 1;
+    for (const auto& pattern : patterns_) {
+        for (unsigned char byte : pattern) {
+            unsigned char folded = fold(byte, case_insensitive_);
+            if (byte_class_[folded] == 0) {
+                byte_class_[folded] = static_cast<uint16_t>(stride_++);
+            }
+        }
+    }
+    if (case_insensitive_) {
+        for (int byte = 'A'; byte <= 'Z'; ++byte) {
+            byte_class_[byte] = byte_class_[std::tolower(byte)];
+        }
+    }
+
+    // Build the trie
+    constexpr uint32_t kMissing = UINT32_MAX;
+    transitions_.assign(stride_, kMissing);
+    depth_.assign(1, 0);
+    output_.assign(1, kNoPattern);
+
+    for (size_t index = 0; index < patterns_.size(); ++index) {
+        uint32_t state = kRoot;
+        for (unsigned char byte : patterns_[index]) {
+            size_t slot = state * stride_ + byte_class_[byte];
+            if (transitions_[slot] == kMissing) {
+                uint32_t next = static_cast<uint32_t>(depth_.size());
+                transitions_[slot] = next;
+                transitions_.resize(transitions_.size() + stride_, kMissing);
+                depth_.push_back(depth_[state] + 1);
+                output_.push_back(kNoPattern);
+            }
+            state = transitions_[slot];
+        }
+        // Duplicate patterns report the first occurrence
+        if (output_[state] == kNoPattern) {
+            output_[state] = static_cast<uint32_t>(index);
+        }
+    }
+
+    // Compute failure links breadth-first and fold them into the table, so
+    // every state has a complete row and searching never follows a link
+    std::vector<uint32_t> fail(depth_.size(), kRoot);
+    output_link_.assign(depth_.size(), kNoPattern);
+    std::queue<uint32_t> pending;
+
+    for (size_t cls = 0; cls < stride_; ++cls) {
+        uint32_t& next = transitions_[kRoot * stride_ + cls];
+        if (next == kMissing) {
+            next = kRoot;
+        } else {
+            pending.push(next);
+        }
+    }
+
+    while (!pending.empty()) {
+        uint32_t state = pending.front();
+        pending.pop();
+
+        for (size_t cls = 0; cls < stride_; ++cls) {
+            uint32_t& next = transitions_[state * stride_ + cls];
+            uint32_t fallback = transitions_[fail[state] * stride_ + cls];
+            if (next == kMissing) {
+                next = fallback;
+                continue;
+            }
+            fail[next] = fallback;
+            output_link_[next] = output_[fallback] != kNoPattern ? fallback : output_link_[fallback];
+            pending.push(next);
+        }
+    }
+
+    // Small sets are prefiltered by jumping between their possible first
+    // bytes while the automaton sits in the root state
+    std::string first_bytes;
+    for (size_t byte = 0; byte < 256; ++byte) {
+        uint32_t next = transitions_[kRoot * stride_ + byte_class_[byte]];
+        if (next != kRoot) {
+            first_bytes.push_back(static_cast<char>(byte));
+        }
+    }
+    if (first_bytes.size() <= 3) {
+        start_bytes_ = first_bytes;
+    }
+}
+
+std::optional<AhoCorasickMatcher::Hit> AhoCorasickMatcher::find_leftmost(std::string_view text,
+                                                                        size_t start_offset) const {
+    if (!is_valid()) {
+        return std::nullopt;
+    }
+
+    std::optional<Hit> best;
+    uint32_t state = kRoot;
+    size_t i = start_offset;
+
+    while (i < text.size()) {
+        if (state == kRoot && !start_bytes_.empty()) {
+            i = simd::find_any_of(text, i, start_bytes_);
+            if (i == std::string_view::npos) {
+                break;
+            }
+        }
+
+        state = next_state(state, static_cast<unsigned char>(text[i]));
+        ++i;
+
+        uint32_t out = output_[state] != kNoPattern ? state : output_link_[state];
+        for (; out != kNoPattern; out = output_link_[out]) {
+            size_t start = i - depth_[out];
+            if (!best || start < best->start || (start == best->start && i > best->end)) {
+                best = Hit{start, i, output_[out]};
+            }
+        }
+
+        // Nothing still in progress can start at or before the best match
+        if (best && i - depth_[state] > best->start) {
+            break;
+        }
+    }
+
+    return best;
+}
+
+std::vector<Match> AhoCorasickMatcher::find_all(std::string_view text) const {
+    std::vector<Match> matches;
+
+    for (auto hit = find_leftmost(text, 0); hit; hit = find_leftmost(text, hit->end)) {
+        Match match;
+        match.start = hit->start;
+        match.end = hit->end;
+        match.text = std::string(text.substr(hit->start, hit->end - hit->start));
+        match.pattern_index = hit->pattern;
+        matches.push_back(match);
+    }
+
+    return matches;
+}
+
+bool AhoCorasickMatcher::matches(std::string_view text) const {
+    if (!is_valid() || text.empty()) {
+        return false;
+    }
+
+    // The final state spells the longest suffix of text that is in the trie
+    uint32_t state = kRoot;
+    for (unsigned char byte : text) {
+        state = next_state(state, byte);
+    }
+    return depth_[state] == text.size() && output_[state] != kNoPattern;
+}
+
+std::optional<Match> AhoCorasickMatcher::find_first(std::string_view text) const {
+    auto hit = find_leftmost(text, 0);
+    if (!hit) {
+        return std::nullopt;
+    }
+
+    Match match;
+    match.start = hit->start;
+    match.end = hit->end;
+    match.text = std::string(text.substr(hit->start, hit->end - hit->start));
+    match.pattern_index = hit->pattern;
+    return match;
+}
+
+std::optional<MatchRange> AhoCorasickMatcher::find_next(std::string_view text, size_t start_offset) const {
+    auto hit = find_leftmost(text, start_offset);
+    if (!hit) {
+        return std::nullopt;
+    }
+    return MatchRange{hit->start, hit->end};
+}
+
+} // namespace cpp_ripgrep
@@ -0,0 +1,221 @@
+#include "chunk_reader.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace cpp_ripgrep {
+
+#ifdef HAVE_ZLIB
+struct ChunkReader::Inflater {
+    z_stream stream{};
+    std::vector<unsigned char> input;
+    bool input_eof = false;
+    bool finished = false;
+
+    Inflater() : input(kCompressedBlockSize) {
+        // 16 + MAX_WBITS: expect a gzip header and trailer
+        if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) {
+            throw std::runtime_error("Cannot initialize zlib");
+        }
+    }
+
+    ~Inflater() {
+        inflateEnd(&stream);
+    }
+};
+#else
+struct ChunkReader::Inflater {};
+#endif
+
+ChunkReader::ChunkReader(NativeHandle handle, size_t chunk_size, Compression compression, size_t binary_probe,
+                         size_t max_line_size)
+    : handle_(handle), buffer_(chunk_size > 0 ? chunk_size : kDefaultChunkSize),
+      max_line_size_(std::max(max_line_size, buffer_.size())), binary_probe_(binary_probe) {
+    if (compression == Compression::GZIP) {
+#ifdef HAVE_ZLIB
+        try {
+            inflater_ = std::make_unique<Inflater>();
+        } catch (...) {
+            // The handle is ours even when construction fails
+            close_handle(handle_);
+            throw;
+        }
+#else
+        close_handle(handle_);
+        throw std::runtime_error("gzip support not compiled in");
+#endif
+    }
+}
+
+ChunkReader::~ChunkReader() {
+    close_handle(handle_);
+}
+
+void ChunkReader::close_handle(NativeHandle handle) {
+#ifdef _WIN32
+    CloseHandle(handle);
+#else
+    close(handle);
+#endif
+}
+
+size_t ChunkReader::read_some(char* data, size_t size) {
+    return inflater_ ? inflate_some(data, size) : read_raw(data, size);
+}
+
+size_t ChunkReader::inflate_some(char* data, size_t size) {
+#ifdef HAVE_ZLIB
+    Inflater& state = *inflater_;
+    z_stream& stream = state.stream;
+    stream.next_out = reinterpret_cast<Bytef*>(data);
+    stream.avail_out = static_cast<uInt>(size);
+
+    // Keep unconsumed input at the front and top the block up
+    auto refill = [&]() {
+        if (state.input_eof) {
+            return;
+        }
+        size_t kept = stream.avail_in;
+        if (kept > 0 && stream.next_in != state.input.data()) {
+            std::memmove(state.input.data(), stream.next_in, kept);
+        }
+        size_t n = read_raw(reinterpret_cast<char*>(state.input.data()) + kept, state.input.size() - kept);
+        if (n == 0) {
+            state.input_eof = true;
+        }
+        stream.next_in = state.input.data();
+        stream.avail_in = static_cast<uInt>(kept + n);
+    };
+
+    while (stream.avail_out == size && !state.finished) {
+        if (stream.avail_in == 0) {
+            refill();
+            if (stream.avail_in == 0) {
+                throw std::runtime_error("Truncated gzip data");
+            }
+        }
+
+        int ret = inflate(&stream, Z_NO_FLUSH);
+        if (ret == Z_STREAM_END) {
+            // Another member may follow (e.g. concatenated rotations);
+            // anything else after the first member is ignored, like gzip -d
+            if (stream.avail_in < 2) {
+                refill();
+            }
+            if (stream.avail_in >= 2 && stream.next_in[0] == 0x1f && stream.next_in[1] == 0x8b) {
+                inflateReset(&stream);
+            } else {
+                state.finished = true;
+            }
+        } else if (ret == Z_BUF_ERROR) {
+            // No progress without more input
+            if (state.input_eof && stream.avail_in == 0) {
+                throw std::runtime_error("Truncated gzip data");
+            }
+            refill();
+        } else if (ret != Z_OK) {
+            throw std::runtime_error(std::string("Corrupt gzip data: ") +
+                                     (stream.msg ? stream.msg : "inflate failed"));
+        }
+    }
+    return size - stream.avail_out;
+#else
+    (void)data;
+    (void)size;
+    return 0;
+#endif
+}
+
+size_t ChunkReader::read_raw(char* data, size_t size) {
+#ifdef _WIN32
+    DWORD bytes_read = 0;
+    DWORD request = static_cast<DWORD>(size > 0x40000000 ? 0x40000000 : size);
+    if (!ReadFile(handle_, data, request, &bytes_read, nullptr)) {
+        throw std::runtime_error("Cannot read file");
+    }
+    return bytes_read;
+#else
+    while (true) {
+        ssize_t n = ::read(handle_, data, size);
+        if (n >= 0) {
+            return static_cast<size_t>(n);
+        }
+        if (errno != EINTR) {
+            throw std::runtime_error(std::string("Cannot read file: ") + std::strerror(errno));
+        }
+    }
+#endif
+}
+
+bool ChunkReader::next(std::string_view& chunk) {
+    // Move the carried partial line to the front
+    size_t filled = tail_end_ - tail_start_;
+    if (filled > 0 && tail_start_ > 0) {
+        std::memmove(buffer_.data(), buffer_.data() + tail_start_, filled);
+    }
+    tail_start_ = tail_end_ = 0;
+
+    while (!eof_) {
+        // A line longer than the buffer: grow it until the line fits, or
+        // hand out what the largest buffer holds as a piece of the line
+        if (filled == buffer_.size()) {
+            if (buffer_.size() >= max_line_size_) {
+                chunk = std::string_view(buffer_.data(), filled);
+                return true;
+            }
+            buffer_.resize(std::min(buffer_.size() * 2, max_line_size_));
+        }
+
+        size_t n = read_some(buffer_.data() + filled, buffer_.size() - filled);
+        if (n == 0) {
+            eof_ = true;
+            break;
+        }
+
+        // A NUL in the first block marks the file binary; stop before the
+        // buffer grows or anything more is read
+        if (binary_probe_ > 0) {
+            const bool binary = std::memchr(buffer_.data(), '\0', std::min(n, binary_probe_)) != nullptr;
+            binary_probe_ = 0;
+            if (binary) {
+                eof_ = true;
+                chunk = std::string_view(buffer_.data(), n);
+                return true;
+            }
+        }
+
+        // Only the new bytes can hold the chunk's last newline
+        std::string_view fresh(buffer_.data() + filled, n);
+        size_t newline = fresh.rfind('\n');
+        filled += n;
+        if (newline == std::string_view::npos) {
+            continue;
+        }
+
+        size_t end = (fresh.data() - buffer_.data()) + newline + 1;
+        tail_start_ = end;
+        tail_end_ = filled;
+        chunk = std::string_view(buffer_.data(), end);
+        return true;
+    }
+
+    // The final line has no terminator
+    if (filled == 0) {
+        return false;
+    }
+    chunk = std::string_view(buffer_.data(), filled);
+    return true;
+}
+
+} // namespace cpp_ripgrep
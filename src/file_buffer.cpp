@@ -0,0 +1,84 @@
+#include "file_buffer.hpp"
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace cpp_ripgrep {
+
+FileBuffer::~FileBuffer() {
+    cleanup();
+}
+
+FileBuffer::FileBuffer(FileBuffer&& other) noexcept {
+    move_from(std::move(other));
+}
+
+FileBuffer& FileBuffer::operator=(FileBuffer&& other) noexcept {
+    if (this != &other) {
+        cleanup();
+        move_from(std::move(other));
+    }
+    return *this;
+}
+
+FileBuffer FileBuffer::from_mapping(void* address, size_t size) {
+    FileBuffer buffer;
+    buffer.mapping_ = address;
+    buffer.mapping_size_ = size;
+    buffer.data_ = static_cast<const char*>(address);
+    buffer.size_ = size;
+    return buffer;
+}
+
+FileBuffer FileBuffer::from_string(std::string contents) {
+    FileBuffer buffer;
+    buffer.owned_ = std::move(contents);
+    buffer.data_ = buffer.owned_.data();
+    buffer.size_ = buffer.owned_.size();
+    return buffer;
+}
+
+void FileBuffer::truncate(size_t size) {
+    if (size < size_) {
+        size_ = size;
+    }
+}
+
+void FileBuffer::cleanup() {
+    if (mapping_) {
+#ifdef _WIN32
+        UnmapViewOfFile(mapping_);
+#else
+        munmap(mapping_, mapping_size_);
+#endif
+        mapping_ = nullptr;
+        mapping_size_ = 0;
+    }
+    owned_.clear();
+    data_ = nullptr;
+    size_ = 0;
+}
+
+void FileBuffer::move_from(FileBuffer&& other) {
+    mapping_ = other.mapping_;
+    mapping_size_ = other.mapping_size_;
+    size_ = other.size_;
+    if (mapping_) {
+        data_ = other.data_;
+    } else {
+        // The small-string buffer moves with the string, so re-derive data_
+        owned_ = std::move(other.owned_);
+        data_ = owned_.data();
+    }
+    other.mapping_ = nullptr;
+    other.mapping_size_ = 0;
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.owned_.clear();
+}
+
+} // namespace cpp_ripgrep
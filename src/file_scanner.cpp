@@ -1,9 +1,11 @@
 #include "file_scanner.hpp"
 #include "options.hpp"
+#include "simd_utils.hpp"
 #include <fstream>
 #include <iostream>
 #include <algorithm>
 #include <cstring>
+#include <cerrno>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -17,22 +19,54 @@
 
 namespace cpp_ripgrep {
 
-FileScanner::FileScanner(const Options& options) : options_(options) {}
+FileScanner::FileScanner(const Options& options) : options_(options) {
+    if (!options_.cache_path.empty()) {
+        cache_ = MetadataCache::open(options_.cache_path);
+    }
+    
+    std::vector<GlobSet::Entry> globs;
+    for (const auto& pattern : options_.exclude_patterns) {
+        if (pattern.size() > 1 && pattern.back() == '/') {
+            globs.push_back(GlobSet::Entry{pattern.substr(0, pattern.size() - 1), kExcludeDirectoryTag});
+        } else {
+            globs.push_back(GlobSet::Entry{pattern, kExcludeTag});
+        }
+    }
+    has_excludes_ = !options_.exclude_patterns.empty();
+    for (const auto& pattern : options_.include_patterns) {
+        globs.push_back(GlobSet::Entry{pattern, kIncludeTag});
+    }
+    filters_ = std::make_unique<GlobSet>(globs);
+}
 
 void FileScanner::scan(const std::vector<std::string>& paths, 
                       std::function<void(const FileInfo&)> file_callback) {
+    scan_roots(paths, [&](const std::string& directory) {
+        scan_directory(directory, 0, nullptr, file_callback);
+    }, file_callback);
+}
+
+void FileScanner::scan_roots(const std::vector<std::string>& paths,
+                             const std::function<void(const std::string&)>& directory_callback,
+                             const std::function<void(const FileInfo&)>& file_callback) const {
     for (const auto& path : paths) {
         try {
             std::filesystem::path fs_path(path);
             
             if (!std::filesystem::exists(fs_path)) {
-                std::cerr << "Warning: Path does not exist: " << path << "\n";
+                if (on_warning_) {
+                    on_warning_(path, "path does not exist");
+                } else {
+                    std::cerr << "Warning: Path does not exist: " << path << "\n";
+                }
                 continue;
             }
             
             if (std::filesystem::is_directory(fs_path)) {
                 if (options_.recursive) {
-                    scan_directory(path, 0, file_callback);
+                    directory_callback(path);
+                } else if (on_warning_) {
+                    on_warning_(path, "skipping directory (not recursive)");
                 } else {
                     std::cerr << "Warning: Skipping directory (use -r for recursive): " << path << "\n";
                 }
@@ -43,19 +77,54 @@ void FileScanner::scan(const std::vector<std::string>& paths,
                 }
             }
         } catch (const std::exception& e) {
-            std::cerr << "Error scanning path " << path << ": " << e.what() << "\n";
+            if (on_error_) {
+                on_error_(path, e.what());
+            } else {
+                std::cerr << "Error scanning path " << path << ": " << e.what() << "\n";
+            }
         }
     }
 }
 
-void FileScanner::scan_directory(const std::string& path, int depth,
+void FileScanner::scan_directory(const std::string& path, int depth, const IgnoreRules::Ptr& ignore,
                                 std::function<void(const FileInfo&)> file_callback) {
     if (options_.max_depth >= 0 && depth > options_.max_depth) {
         return;
     }
     
+    read_directory(path, ignore, [&](const std::string& subdirectory, const IgnoreRules::Ptr& rules) {
+        scan_directory(subdirectory, depth + 1, rules, file_callback);
+    }, file_callback);
+}
+
+void FileScanner::read_directory(const std::string& path, const IgnoreRules::Ptr& inherited,
+                                 const std::function<void(const std::string&, const IgnoreRules::Ptr&)>& directory_callback,
+                                 const std::function<void(const FileInfo&)>& file_callback) const {
     try {
-        for (const auto& entry : std::filesystem::directory_iterator(path)) {
+        std::vector<std::filesystem::directory_entry> entries(std::filesystem::directory_iterator(path), {});
+        if (options_.sort_files) {
+            std::sort(entries.begin(), entries.end(),
+                      [](const auto& a, const auto& b) { return a.path() < b.path(); });
+        }
+        
+        // Compile this directory's ignore files, if it has any, on top of
+        // the inherited rules; the listing tells us which exist
+        IgnoreRules::Ptr ignore = inherited;
+        if (!options_.no_ignore) {
+            std::vector<std::string> ignore_files;
+            for (const auto& entry : entries) {
+                std::string name = entry.path().filename().string();
+                for (const char* ignore_file : IgnoreRules::kIgnoreFiles) {
+                    if (name == ignore_file) {
+                        ignore_files.push_back(std::move(name));
+                        break;
+                    }
+                }
+            }
+            ignore = IgnoreRules::load(path, ignore_files, inherited);
+        }
+        
+        for (const auto& entry : entries) {
             const std::string entry_path = entry.path().string();
             
             // Skip hidden files and directories
@@ -63,21 +132,40 @@ void FileScanner::scan_directory(const std::string& path, int depth,
                 continue;
             }
             
-            if (entry.is_directory()) {
-                scan_directory(entry_path, depth + 1, file_callback);
+            const bool is_directory = entry.is_directory();
+            if (ignore && ignore->is_ignored(entry_path, is_directory)) {
+                continue;
+            }
+            
+            if (is_directory) {
+                if (should_scan_directory(entry_path)) {
+                    directory_callback(entry_path, ignore);
+                }
             } else if (entry.is_regular_file()) {
                 if (should_scan_file(entry_path)) {
-                    FileInfo info = get_file_info(entry_path);
+                    // The listing already says what the entry is; the
+                    // size is learned when the file is read
+                    FileInfo info;
+                    info.path = entry_path;
+                    info.name = entry.path().filename().string();
+                    info.is_directory = false;
+                    info.size = 0;
+                    info.type = std::filesystem::file_type::regular;
                     file_callback(info);
                 }
             }
         }
     } catch (const std::exception& e) {
-        std::cerr << "Error scanning directory " << path << ": " << e.what() << "\n";
+        if (on_error_) {
+            on_error_(path, e.what());
+        } else {
+            std::cerr << "Error scanning directory " << path << ": " << e.what() << "\n";
+        }
     }
 }
 
-std::string FileScanner::read_file(const std::string& path) const {
+FileBuffer FileScanner::read_file(const std::string& path, std::unique_ptr<ChunkReader>* stream,
+                                  size_t max_mapped_size) const {
 #ifdef _WIN32
     // Windows implementation using CreateFile and memory mapping
     HANDLE hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, 
@@ -94,19 +182,37 @@ std::string FileScanner::read_file(const std::string& path) const {
     
     if (fileSize.QuadPart == 0) {
         CloseHandle(hFile);
-        return "";
+        return FileBuffer();
+    }
+    
+    // -z: gzip files are inflated as they are read, whatever their size
+    if (options_.search_zip) {
+        unsigned char magic[2];
+        DWORD magic_read = 0;
+        LARGE_INTEGER start = {};
+        if (ReadFile(hFile, magic, sizeof(magic), &magic_read, nullptr) && magic_read == 2 && is_gzip(magic)) {
+            SetFilePointerEx(hFile, start, nullptr, FILE_BEGIN);
+            return open_gzip(hFile, stream);
+        }
+        SetFilePointerEx(hFile, start, nullptr, FILE_BEGIN);
     }
     
     // Check if file is too large for memory mapping
-    if (fileSize.QuadPart > 100 * 1024 * 1024) { // 100MB limit
+    if (static_cast<unsigned long long>(fileSize.QuadPart) > max_mapped_size) {
+        if (stream) {
+            // Too large to hold at once: the caller reads it in chunks
+            *stream = std::make_unique<ChunkReader>(hFile, ChunkReader::kDefaultChunkSize,
+                                                    ChunkReader::Compression::NONE, kBinaryProbeSize);
+            return FileBuffer();
+        }
         CloseHandle(hFile);
         // Fall back to regular file reading
         std::ifstream file(path, std::ios::binary);
         if (!file) {
             throw std::runtime_error("Cannot open file: " + path);
         }
-        return std::string(std::istreambuf_iterator<char>(file), 
-                          std::istreambuf_iterator<char>());
+        return filter_binary(FileBuffer::from_string(std::string(std::istreambuf_iterator<char>(file), 
+                                                                 std::istreambuf_iterator<char>())));
     }
     
     HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
@@ -123,10 +229,7 @@ std::string FileScanner::read_file(const std::string& path) const {
         throw std::runtime_error("Cannot map view of file: " + path);
     }
     
-    std::string content(static_cast<const char*>(mapped), fileSize.QuadPart);
-    UnmapViewOfFile(mapped);
-    
-    return content;
+    return filter_binary(FileBuffer::from_mapping(mapped, static_cast<size_t>(fileSize.QuadPart)));
 #else
     // Unix/Linux implementation using mmap
     int fd = open(path.c_str(), O_RDONLY);
@@ -142,19 +245,74 @@ std::string FileScanner::read_file(const std::string& path) const {
     
     if (st.st_size == 0) {
         close(fd);
-        return "";
+        return FileBuffer();
     }
     
+    // -z: gzip files are inflated as they are read, whatever their size.
+    // Checked before the cache, which records them as binary.
+    unsigned char magic[2];
+    if (options_.search_zip && ::pread(fd, magic, sizeof(magic), 0) == 2 && is_gzip(magic)) {
+        return open_gzip(fd, stream);
+    }
+    
+    // A file the cache already knows to be binary is not read at all
+    FileIdentity identity;
+    MetadataCache::Kind known = MetadataCache::Kind::UNKNOWN;
+    if (cache_) {
+        identity.device = static_cast<uint64_t>(st.st_dev);
+        identity.inode = static_cast<uint64_t>(st.st_ino);
+#ifdef __APPLE__
+        identity.mtime = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+        identity.mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+        identity.size = static_cast<uint64_t>(st.st_size);
+        known = cache_->lookup(identity);
+        if (known == MetadataCache::Kind::BINARY) {
+            close(fd);
+            cache_->count_binary_skip();
+            return FileBuffer();
+        }
+    }
+    const FileIdentity* cache_key = cache_ ? &identity : nullptr;
+    
     // Check if file is too large for memory mapping
-    if (st.st_size > 100 * 1024 * 1024) { // 100MB limit
-        close(fd);
-        // Fall back to regular file reading
-        std::ifstream file(path, std::ios::binary);
-        if (!file) {
-            throw std::runtime_error("Cannot open file: " + path);
+    const bool too_large = static_cast<size_t>(st.st_size) > max_mapped_size;
+    if (too_large && stream) {
+        // Only the first block decides, so classify it for the cache here
+        if (cache_key && known == MetadataCache::Kind::UNKNOWN) {
+            char probe[kBinaryProbeSize];
+            ssize_t n = ::pread(fd, probe, sizeof(probe), 0);
+            if (n > 0) {
+                const bool binary = searchable_length(std::string_view(probe, static_cast<size_t>(n)), true) == 0;
+                cache_->record(identity, binary ? MetadataCache::Kind::BINARY : MetadataCache::Kind::TEXT);
+            }
         }
-        return std::string(std::istreambuf_iterator<char>(file), 
-                          std::istreambuf_iterator<char>());
+        
+        // Too large to hold at once: the caller reads it in chunks
+        *stream = std::make_unique<ChunkReader>(fd, ChunkReader::kDefaultChunkSize,
+                                                ChunkReader::Compression::NONE, kBinaryProbeSize);
+        return FileBuffer();
+    }
+    
+    // The pread and io_uring backends (the latter when called synchronously)
+    // read instead of mapping, as do files too large to map
+    if (too_large || options_.io_backend != IoBackend::MMAP) {
+        std::string contents(static_cast<size_t>(st.st_size), '\0');
+        size_t filled = 0;
+        while (filled < contents.size()) {
+            ssize_t n = ::pread(fd, &contents[filled], contents.size() - filled, static_cast<off_t>(filled));
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                break;
+            }
+            filled += static_cast<size_t>(n);
+        }
+        close(fd);
+        contents.resize(filled);
+        return filter_binary(FileBuffer::from_string(std::move(contents)), cache_key, known);
     }
     
     void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
@@ -164,14 +322,98 @@ std::string FileScanner::read_file(const std::string& path) const {
         throw std::runtime_error("Cannot memory map file: " + path);
     }
     
-    std::string content(static_cast<const char*>(mapped), st.st_size);
-    munmap(mapped, st.st_size);
+    // Search runs straight over the mapping, so hint the kernel to read ahead
+    madvise(mapped, st.st_size, MADV_SEQUENTIAL);
     
-    return content;
+    return filter_binary(FileBuffer::from_mapping(mapped, static_cast<size_t>(st.st_size)), cache_key, known);
 #endif
 }
 
-std::vector<LineInfo> FileScanner::get_lines(const std::string& content) const {
+bool FileScanner::is_gzip(const unsigned char* magic) {
+    return magic[0] == 0x1f && magic[1] == 0x8b;
+}
+
+FileBuffer FileScanner::open_gzip(ChunkReader::NativeHandle handle, std::unique_ptr<ChunkReader>* stream) const {
+    auto reader = std::make_unique<ChunkReader>(handle, ChunkReader::kDefaultChunkSize,
+                                                ChunkReader::Compression::GZIP, kBinaryProbeSize);
+    if (stream) {
+        *stream = std::move(reader);
+        return FileBuffer();
+    }
+    
+    // No stream wanted: inflate the whole file
+    std::string contents;
+    std::string_view chunk;
+    while (reader->next(chunk)) {
+        contents.append(chunk.data(), chunk.size());
+    }
+    return filter_binary(FileBuffer::from_string(std::move(contents)));
+}
+
+FileBuffer FileScanner::filter_binary(FileBuffer buffer) const {
+    return filter_binary(std::move(buffer), nullptr, MetadataCache::Kind::UNKNOWN);
+}
+
+FileBuffer FileScanner::filter_binary(FileBuffer buffer, const FileIdentity* identity,
+                                      MetadataCache::Kind known) const {
+    // Known text has no NUL in its first block, so only --stop-at-nul
+    // can shorten it
+    if (known == MetadataCache::Kind::TEXT) {
+        buffer.truncate(searchable_length(buffer.view(), false));
+        return buffer;
+    }
+    
+    const size_t length = searchable_length(buffer.view(), true);
+    if (identity) {
+        const bool binary = std::memchr(buffer.data(), '\0', std::min(buffer.size(), kBinaryProbeSize)) != nullptr;
+        cache_->record(*identity, binary ? MetadataCache::Kind::BINARY : MetadataCache::Kind::TEXT);
+    }
+    buffer.truncate(length);
+    return buffer;
+}
+
+void FileScanner::set_diagnostic_handlers(DiagnosticHandler warning, DiagnosticHandler error) {
+    on_warning_ = std::move(warning);
+    on_error_ = std::move(error);
+}
+
+void FileScanner::save_cache() const {
+    std::string error;
+    if (!cache_ || cache_->save(error)) {
+        return;
+    }
+    if (on_warning_) {
+        on_warning_(options_.cache_path, "cannot save metadata cache: " + error);
+    } else {
+        std::cerr << "Warning: Cannot save metadata cache: " << error << "\n";
+    }
+}
+
+size_t FileScanner::searchable_length(std::string_view content, bool at_file_start) const {
+    static constexpr std::string_view kNul("\0", 1);
+    
+    // A NUL byte in the first block marks the whole file as binary
+    size_t probe = 0;
+    if (at_file_start) {
+        probe = std::min(content.size(), kBinaryProbeSize);
+        if (simd::find_any_of(content.substr(0, probe), 0, kNul) != std::string_view::npos) {
+            return 0;
+        }
+    }
+    
+    // Optionally stop at the first NUL further in, dropping its whole line
+    if (options_.stop_at_nul) {
+        size_t nul = simd::find_any_of(content, probe, kNul);
+        if (nul != std::string_view::npos) {
+            size_t line_end = content.rfind('\n', nul);
+            return line_end == std::string_view::npos ? 0 : line_end + 1;
+        }
+    }
+    
+    return content.size();
+}
+
+std::vector<LineInfo> FileScanner::get_lines(std::string_view content) const {
     std::vector<LineInfo> lines;
     size_t pos = 0;
     size_t line_number = 1;
@@ -180,7 +422,7 @@ std::vector<LineInfo> FileScanner::get_lines(const std::string& content) const {
         size_t start_pos = pos;
         size_t end_pos = content.find('\n', pos);
         
-        if (end_pos == std::string::npos) {
+        if (end_pos == std::string_view::npos) {
             end_pos = content.length();
         }
         
@@ -188,7 +430,7 @@ std::vector<LineInfo> FileScanner::get_lines(const std::string& content) const {
         line.line_number = line_number;
         line.start_pos = start_pos;
         line.end_pos = end_pos;
-        line.content = content.substr(start_pos, end_pos - start_pos);
+        line.content = std::string(content.substr(start_pos, end_pos - start_pos));
         
         // Remove carriage return if present
         if (!line.content.empty() && line.content.back() == '\r') {
@@ -205,111 +447,44 @@ std::vector<LineInfo> FileScanner::get_lines(const std::string& content) const {
 }
 
 bool FileScanner::should_scan_file(const std::string& path) const {
-    // Check exclude patterns
-    if (!options_.exclude_patterns.empty()) {
-        for (const auto& pattern : options_.exclude_patterns) {
-            if (matches_pattern(path, {pattern})) {
-                return false;
-            }
-        }
-    }
-    
-    // Check include patterns
-    if (!options_.include_patterns.empty()) {
-        bool included = false;
-        for (const auto& pattern : options_.include_patterns) {
-            if (matches_pattern(path, {pattern})) {
-                included = true;
-                break;
-            }
-        }
-        if (!included) {
-            return false;
-        }
+    // One pass over the compiled include/exclude globs
+    const uint32_t matched = filters_->matches(path);
+    if (matched & (1u << kExcludeTag)) {
+        return false;
     }
-    
-    // Skip binary files
-    if (is_binary_file(path)) {
+    if (!options_.include_patterns.empty() && !(matched & (1u << kIncludeTag))) {
         return false;
     }
     
+    // Binary files are detected later on the contents read_file maps, so
+    // the file is only opened once
     return true;
 }
 
+bool FileScanner::should_scan_directory(const std::string& path) const {
+    if (!has_excludes_) {
+        return true;
+    }
+    return !(filters_->matches(path) & ((1u << kExcludeTag) | (1u << kExcludeDirectoryTag)));
+}
+
 FileInfo FileScanner::get_file_info(const std::string& path) {
     FileInfo info;
     info.path = path;
     info.name = std::filesystem::path(path).filename().string();
     
-    try {
-        std::filesystem::path fs_path(path);
-        info.is_directory = std::filesystem::is_directory(fs_path);
-        info.type = std::filesystem::status(fs_path).type();
-        
-        if (std::filesystem::is_regular_file(fs_path)) {
-            info.size = std::filesystem::file_size(fs_path);
-        } else {
-            info.size = 0;
-        }
-    } catch (const std::exception& e) {
-        info.is_directory = false;
-        info.size = 0;
-        info.type = std::filesystem::file_type::unknown;
+    // One status call answers type and size together
+    std::error_code error;
+    std::filesystem::file_status status = std::filesystem::status(path, error);
+    info.type = error ? std::filesystem::file_type::unknown : status.type();
+    info.is_directory = info.type == std::filesystem::file_type::directory;
+    info.size = 0;
+    if (info.type == std::filesystem::file_type::regular) {
+        auto size = std::filesystem::file_size(path, error);
+        info.size = error ? 0 : static_cast<size_t>(size);
     }
     
     return info;
 }
 
-bool FileScanner::matches_pattern(const std::string& path, 
-                                 const std::vector<std::string>& patterns) const {
-    std::string filename = std::filesystem::path(path).filename().string();
-    
-    for (const auto& pattern : patterns) {
-        // Simple glob-like pattern matching
-        if (pattern.find('*') != std::string::npos || 
-            pattern.find('?') != std::string::npos) {
-            // TODO: Implement proper glob matching
-            // For now, just check if pattern is a substring
-            if (filename.find(pattern) != std::string::npos) {
-                return true;
-            }
-        } else {
-            // Exact match
-            if (filename == pattern) {
-                return true;
-            }
-        }
-    }
-    
-    return false;
-}
-
-bool FileScanner::is_binary_file(const std::string& path) const {
-    try {
-        std::ifstream file(path, std::ios::binary);
-        if (!file) {
-            return true; // Assume binary if can't open
-        }
-        
-        // Read first 1024 bytes to check for null bytes
-        char buffer[1024];
-        file.read(buffer, sizeof(buffer));
-        std::streamsize bytes_read = file.gcount();
-        
-        for (std::streamsize i = 0; i < bytes_read; ++i) {
-            if (buffer[i] == '\0') {
-                return true;
-            }
-        }
-        
-        return false;
-    } catch (...) {
-        return true; // Assume binary on error
-    }
-}
-
-bool FileScanner::is_text_file(const std::string& path) const {
-    return !is_binary_file(path);
-}
-
 } // namespace cpp_ripgrep 
\ No newline at end of file
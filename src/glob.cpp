@@ -0,0 +1,154 @@
+#include "glob.hpp"
+
+namespace cpp_ripgrep {
+
+namespace {
+
+bool has_wildcards(std::string_view text) {
+    return text.find_first_of("*?[\\") != std::string_view::npos;
+}
+
+} // namespace
+
+Glob::Glob(std::string pattern) : pattern_(std::move(pattern)) {
+    if (!has_wildcards(pattern_)) {
+        kind_ = Kind::LITERAL;
+        literal_ = pattern_;
+    } else if (pattern_.size() > 1 && pattern_[0] == '*' && pattern_[1] != '*' &&
+               !has_wildcards(std::string_view(pattern_).substr(1)) &&
+               pattern_.find('/') == std::string::npos) {
+        kind_ = Kind::SUFFIX;
+        literal_ = pattern_.substr(1);
+    } else {
+        kind_ = Kind::GENERAL;
+    }
+}
+
+bool Glob::matches(std::string_view text) const {
+    switch (kind_) {
+        case Kind::LITERAL:
+            return text == literal_;
+        case Kind::SUFFIX:
+            return text.size() >= literal_.size() &&
+                   text.compare(text.size() - literal_.size(), literal_.size(), literal_) == 0 &&
+                   text.substr(0, text.size() - literal_.size()).find('/') == std::string_view::npos;
+        case Kind::GENERAL:
+        default:
+            return match(pattern_, 0, text, 0);
+    }
+}
+
+bool Glob::match_class(std::string_view pattern, size_t& p, unsigned char byte) {
+    // pattern[p] is '['; on return p is just past the closing ']'
+    size_t i = p + 1;
+    bool negated = false;
+    if (i < pattern.size() && (pattern[i] == '!' || pattern[i] == '^')) {
+        negated = true;
+        ++i;
+    }
+
+    bool matched = false;
+    bool first = true;
+    while (i < pattern.size() && (first || pattern[i] != ']')) {
+        first = false;
+        unsigned char low = static_cast<unsigned char>(pattern[i]);
+        if (low == '\\' && i + 1 < pattern.size()) {
+            low = static_cast<unsigned char>(pattern[++i]);
+        }
+        ++i;
+        unsigned char high = low;
+        if (i + 1 < pattern.size() && pattern[i] == '-' && pattern[i + 1] != ']') {
+            high = static_cast<unsigned char>(pattern[i + 1]);
+            if (high == '\\' && i + 2 < pattern.size()) {
+                high = static_cast<unsigned char>(pattern[i + 2]);
+                ++i;
+            }
+            i += 2;
+        }
+        if (low <= byte && byte <= high) {
+            matched = true;
+        }
+    }
+    p = i < pattern.size() ? i + 1 : i;
+    return matched != negated;
+}
+
+bool Glob::match(std::string_view pattern, size_t p, std::string_view text, size_t t) {
+    while (p < pattern.size()) {
+        const char c = pattern[p];
+
+        if (c == '*') {
+            size_t stars_end = p;
+            while (stars_end < pattern.size() && pattern[stars_end] == '*') {
+                ++stars_end;
+            }
+
+            // `**` as a whole path component matches across directories
+            const bool component_start = p == 0 || pattern[p - 1] == '/';
+            if (stars_end - p >= 2 && component_start) {
+                if (stars_end == pattern.size()) {
+                    return true;
+                }
+                if (pattern[stars_end] == '/') {
+                    // Zero or more leading directories
+                    for (size_t s = t;;) {
+                        if (match(pattern, stars_end + 1, text, s)) {
+                            return true;
+                        }
+                        s = text.find('/', s);
+                        if (s == std::string_view::npos) {
+                            return false;
+                        }
+                        ++s;
+                    }
+                }
+            }
+
+            // Otherwise any run of bytes within one path component
+            p = stars_end;
+            if (p == pattern.size()) {
+                return text.find('/', t) == std::string_view::npos;
+            }
+            for (size_t s = t; s <= text.size(); ++s) {
+                if (match(pattern, p, text, s)) {
+                    return true;
+                }
+                if (s < text.size() && text[s] == '/') {
+                    break;
+                }
+            }
+            return false;
+        }
+
+        if (t >= text.size()) {
+            return false;
+        }
+
+        if (c == '?') {
+            if (text[t] == '/') {
+                return false;
+            }
+            ++p;
+            ++t;
+        } else if (c == '[') {
+            if (text[t] == '/' || !match_class(pattern, p, static_cast<unsigned char>(text[t]))) {
+                return false;
+            }
+            ++t;
+        } else {
+            char literal = c;
+            if (c == '\\' && p + 1 < pattern.size()) {
+                literal = pattern[++p];
+            }
+            if (text[t] != literal) {
+                return false;
+            }
+            ++p;
+            ++t;
+        }
+    }
+
+    return t == text.size();
+}
+
+} // namespace cpp_ripgrep
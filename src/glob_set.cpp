@@ -0,0 +1,298 @@
+#include "glob_set.hpp"
+#include <algorithm>
+#include <cstdio>
+
+namespace cpp_ripgrep {
+
+namespace {
+
+bool has_wildcards(std::string_view text) {
+    return text.find_first_of("*?[\\") != std::string_view::npos;
+}
+
+// Match paths as printed, without the "./" a walk from "." puts in front
+std::string_view strip_dot_slash(std::string_view path) {
+    while (path.size() >= 2 && path[0] == '.' && path[1] == '/') {
+        path.remove_prefix(2);
+    }
+    return path;
+}
+
+std::string_view file_name(std::string_view path) {
+    size_t slash = path.rfind('/');
+    return slash == std::string_view::npos ? path : path.substr(slash + 1);
+}
+
+void append_byte(std::string& regex, unsigned char byte) {
+    char escaped[8];
+    std::snprintf(escaped, sizeof(escaped), "\\x%02x", byte);
+    regex += escaped;
+}
+
+void append_literal(std::string& regex, unsigned char byte) {
+    if ((byte >= 'a' && byte <= 'z') || (byte >= 'A' && byte <= 'Z') ||
+        (byte >= '0' && byte <= '9') || byte == '/' || byte == '_') {
+        regex += static_cast<char>(byte);
+    } else {
+        append_byte(regex, byte);
+    }
+}
+
+// Class range [low, high] with '/' cut out, since classes never match it
+void append_range(std::string& regex, unsigned char low, unsigned char high) {
+    auto emit = [&](unsigned char from, unsigned char to) {
+        if (from > to) {
+            return;
+        }
+        append_byte(regex, from);
+        if (to != from) {
+            regex += '-';
+            append_byte(regex, to);
+        }
+    };
+    if (low <= '/' && '/' <= high) {
+        emit(low, '/' - 1);
+        emit('/' + 1, high);
+    } else {
+        emit(low, high);
+    }
+}
+
+} // namespace
+
+GlobSet::GlobSet(const std::vector<Entry>& globs) : count_(globs.size()) {
+    // At most one key per glob; reserving up front keeps the views valid
+    keys_.reserve(globs.size());
+    auto key = [this](std::string text) {
+        keys_.push_back(std::move(text));
+        return std::string_view(keys_.back());
+    };
+
+    for (const auto& entry : globs) {
+        const uint32_t mask = 1u << entry.tag;
+        std::string pattern = entry.pattern;
+
+        const bool whole_path = pattern.find('/') != std::string::npos;
+        if (whole_path && pattern[0] == '/') {
+            pattern.erase(0, 1);
+        }
+
+        if (!has_wildcards(pattern)) {
+            (whole_path ? paths_ : names_)[key(pattern)] |= mask;
+            continue;
+        }
+
+        // `*.ext` with a plain extension
+        if (!whole_path && pattern.size() > 2 && pattern[0] == '*' && pattern[1] == '.' &&
+            !has_wildcards(pattern.substr(2)) && pattern.find('.', 2) == std::string::npos) {
+            extensions_[key(pattern.substr(2))] |= mask;
+            continue;
+        }
+
+        std::string regex;
+#ifdef HAVE_RE2
+        if (to_regex(pattern, regex)) {
+            std::vector<Combined>& sets = whole_path ? path_sets_ : name_sets_;
+            auto it = std::find_if(sets.begin(), sets.end(),
+                                   [mask](const Combined& combined) { return combined.mask == mask; });
+            if (it == sets.end()) {
+                it = sets.insert(sets.end(), Combined());
+                it->mask = mask;
+            }
+            it->globs.push_back(pattern);
+            it->regexes.push_back(std::move(regex));
+            continue;
+        }
+#endif
+        fallback_.push_back(Fallback{Glob(pattern), whole_path, mask});
+    }
+
+    compile(name_sets_, false);
+    compile(path_sets_, true);
+}
+
+GlobSet::~GlobSet() = default;
+
+void GlobSet::compile(std::vector<Combined>& sets, bool whole_path) {
+#ifdef HAVE_RE2
+    re2::RE2::Options options;
+    options.set_encoding(re2::RE2::Options::EncodingLatin1);
+    options.set_dot_nl(true);
+    options.set_log_errors(false);
+
+    for (auto it = sets.begin(); it != sets.end();) {
+        auto set = std::make_unique<re2::RE2::Set>(options, re2::RE2::ANCHOR_BOTH);
+        bool ok = true;
+        for (const auto& regex : it->regexes) {
+            if (set->Add(regex, nullptr) < 0) {
+                ok = false;
+                break;
+            }
+        }
+        if (ok && set->Compile()) {
+            it->set = std::move(set);
+            ++it;
+            continue;
+        }
+
+        // Out of memory or a translation RE2 rejects: match these one by one
+        for (const auto& glob : it->globs) {
+            fallback_.push_back(Fallback{Glob(glob), whole_path, it->mask});
+        }
+        it = sets.erase(it);
+    }
+#else
+    (void)sets;
+    (void)whole_path;
+#endif
+}
+
+uint32_t GlobSet::match_combined(const std::vector<Combined>& sets, std::string_view text, uint32_t known) {
+    uint32_t mask = 0;
+#ifdef HAVE_RE2
+    for (const auto& combined : sets) {
+        // A tag that already matched needs no second pass
+        if ((known & combined.mask) == combined.mask) {
+            continue;
+        }
+        if (combined.set->Match(re2::StringPiece(text.data(), text.size()), nullptr)) {
+            mask |= combined.mask;
+        }
+    }
+#else
+    (void)sets;
+    (void)text;
+    (void)known;
+#endif
+    return mask;
+}
+
+uint32_t GlobSet::matches(std::string_view path) const {
+    if (count_ == 0) {
+        return 0;
+    }
+
+    path = strip_dot_slash(path);
+    const std::string_view name = file_name(path);
+    uint32_t mask = 0;
+
+    if (!extensions_.empty()) {
+        size_t dot = name.rfind('.');
+        if (dot != std::string_view::npos) {
+            auto it = extensions_.find(name.substr(dot + 1));
+            if (it != extensions_.end()) {
+                mask |= it->second;
+            }
+        }
+    }
+    if (!names_.empty()) {
+        auto it = names_.find(name);
+        if (it != names_.end()) {
+            mask |= it->second;
+        }
+    }
+    if (!paths_.empty()) {
+        auto it = paths_.find(path);
+        if (it != paths_.end()) {
+            mask |= it->second;
+        }
+    }
+
+    mask |= match_combined(name_sets_, name, mask);
+    mask |= match_combined(path_sets_, path, mask);
+
+    for (const auto& fallback : fallback_) {
+        if ((mask & fallback.mask) != fallback.mask && fallback.glob.matches(fallback.whole_path ? path : name)) {
+            mask |= fallback.mask;
+        }
+    }
+
+    return mask;
+}
+
+bool GlobSet::to_regex(const std::string& glob, std::string& regex) {
+    regex.clear();
+    const size_t n = glob.size();
+
+    for (size_t p = 0; p < n;) {
+        const char c = glob[p];
+
+        if (c == '*') {
+            size_t stars_end = p;
+            while (stars_end < n && glob[stars_end] == '*') {
+                ++stars_end;
+            }
+            const bool component_start = p == 0 || glob[p - 1] == '/';
+            if (stars_end - p >= 2 && component_start && stars_end == n) {
+                regex += ".*";
+            } else if (stars_end - p >= 2 && component_start && glob[stars_end] == '/') {
+                regex += "(?:.*/)?";
+                ++stars_end;
+            } else {
+                regex += "[^/]*";
+            }
+            p = stars_end;
+        } else if (c == '?') {
+            regex += "[^/]";
+            ++p;
+        } else if (c == '[') {
+            // Same parse as Glob::match_class
+            size_t i = p + 1;
+            std::string cls = "[";
+            if (i < n && (glob[i] == '!' || glob[i] == '^')) {
+                cls += "^/";
+                ++i;
+            }
+            const bool negated = cls.size() > 1;
+            bool first = true;
+            while (i < n && (first || glob[i] != ']')) {
+                first = false;
+                unsigned char low = static_cast<unsigned char>(glob[i]);
+                if (low == '\\' && i + 1 < n) {
+                    low = static_cast<unsigned char>(glob[++i]);
+                }
+                ++i;
+                unsigned char high = low;
+                if (i + 1 < n && glob[i] == '-' && glob[i + 1] != ']') {
+                    high = static_cast<unsigned char>(glob[i + 1]);
+                    if (high == '\\' && i + 2 < n) {
+                        high = static_cast<unsigned char>(glob[i + 2]);
+                        ++i;
+                    }
+                    i += 2;
+                }
+                if (negated) {
+                    if (low <= high) {
+                        append_byte(cls, low);
+                        if (high != low) {
+                            cls += '-';
+                            append_byte(cls, high);
+                        }
+                    }
+                } else {
+                    append_range(cls, low, high);
+                }
+            }
+            if (i >= n) {
+                return false;   // unterminated class
+            }
+            if (cls == "[") {
+                return false;   // only '/' or empty ranges: matches nothing
+            }
+            regex += cls;
+            regex += ']';
+            p = i + 1;
+        } else {
+            unsigned char literal = static_cast<unsigned char>(c);
+            if (c == '\\' && p + 1 < n) {
+                literal = static_cast<unsigned char>(glob[++p]);
+            }
+            append_literal(regex, literal);
+            ++p;
+        }
+    }
+
+    return true;
+}
+
+} // namespace cpp_ripgrep
@@ -3,9 +3,15 @@
 #include "regex_matcher.hpp"
 #include "re2_matcher.hpp"
 #include "file_scanner.hpp"
+#include "simd_utils.hpp"
 #include <iostream>
 #include <algorithm>
-#include <sstream>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
 
 #ifdef _WIN32
 #include <io.h>
@@ -16,27 +22,94 @@
 
 namespace cpp_ripgrep {
 
+namespace {
+
+constexpr const char* kColorMatch = "\033[31m";
+constexpr const char* kColorLineNumber = "\033[32m";
+constexpr const char* kColorPath = "\033[34m";
+constexpr const char* kColorPatternIndex = "\033[35m";
+constexpr const char* kColorReset = "\033[0m";
+
+// Worker threads for options.threads, where 0 means one per core
+size_t worker_count(const Options& options) {
+    if (options.threads > 0) {
+        return static_cast<size_t>(options.threads);
+    }
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Whether pattern uses \A, \z or \Z, which anchor at the subject's ends
+bool has_subject_anchor(const std::string& pattern) {
+    for (size_t i = 0; i + 1 < pattern.size(); ++i) {
+        if (pattern[i] == '\\') {
+            const char next = pattern[++i];
+            if (next == 'A' || next == 'z' || next == 'Z') {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+} // namespace
+
 GrepEngine::GrepEngine(const Options& options) 
-    : options_(options), scanner_(options) {
+    : options_(options), scanner_(options_), pool_(worker_count(options)), output_(1 /* stdout */) {
+    
+    options_.threads = static_cast<int>(pool_.size());
+    const bool regex = options_.mode == SearchMode::REGEX || options_.mode == SearchMode::CASE_INSENSITIVE;
+    anchors_line_end_ = regex && options_.pattern.find('$') != std::string::npos;
+    anchors_subject_ = regex && has_subject_anchor(options_.pattern);
+    use_color_ = !options_.json && options_.color &&
+                 (*options_.color == "always" || (*options_.color == "auto" && output_.is_terminal()));
+    
+#ifndef HAVE_ZLIB
+    if (options_.search_zip) {
+        std::cerr << "Warning: gzip support is not compiled in, -z has no effect\n";
+        options_.search_zip = false;
+    }
+#endif
+    
+    if (options_.io_backend == IoBackend::IO_URING && !UringReader::available()) {
+        std::cerr << "Warning: io_uring is not available, reading files with pread\n";
+        options_.io_backend = IoBackend::PREAD;
+    }
     
     // Create appropriate matcher based on search mode and regex engine
     switch (options.mode) {
         case SearchMode::LITERAL:
-            // For literal search, we'll use the static method
+            literal_searcher_ = std::make_unique<LiteralSearcher>(options.pattern);
+            break;
+        case SearchMode::MULTI_LITERAL:
+            multi_literal_matcher_ = std::make_unique<AhoCorasickMatcher>(options.patterns, options.ignore_case);
+            if (!multi_literal_matcher_->is_valid()) {
+                error_ = "Invalid pattern set: " + multi_literal_matcher_->get_error();
+            }
             break;
         case SearchMode::REGEX:
         case SearchMode::CASE_INSENSITIVE:
-            if (options.regex_engine == RegexEngine::RE2) {
+            if (options.regex_engine == RegexEngine::RE2 && options.patterns.size() > 1) {
+                // Rule sets: one RE2::Set pass decides which rules need running
+                re2_set_matcher_ = std::make_unique<RE2SetMatcher>(options.patterns, options.ignore_case);
+                if (!re2_set_matcher_->is_valid()) {
+                    error_ = "Invalid RE2 regex pattern: " + re2_set_matcher_->get_error();
+                }
+            } else if (options.regex_engine == RegexEngine::RE2) {
                 re2_matcher_ = std::make_unique<RE2Matcher>(options.pattern, options.ignore_case);
                 if (!re2_matcher_->is_valid()) {
-                    std::cerr << "Error: Invalid RE2 regex pattern: " << re2_matcher_->get_error() << "\n";
-                    std::exit(1);
+                    error_ = "Invalid RE2 regex pattern: " + re2_matcher_->get_error();
+                }
+            } else if (options.patterns.size() > 1) {
+                // Several patterns are tagged so matches report which one
+                // fired, and split across programs when there are too many
+                pcre2_set_matcher_ = std::make_unique<RegexSetMatcher>(options.patterns, options.ignore_case);
+                if (!pcre2_set_matcher_->is_valid()) {
+                    error_ = "Invalid PCRE2 regex pattern: " + pcre2_set_matcher_->get_error();
                 }
             } else {
                 pcre2_matcher_ = std::make_unique<RegexMatcher>(options.pattern, options.ignore_case);
                 if (!pcre2_matcher_->is_valid()) {
-                    std::cerr << "Error: Invalid PCRE2 regex pattern: " << pcre2_matcher_->get_error() << "\n";
-                    std::exit(1);
+                    error_ = "Invalid PCRE2 regex pattern: " + pcre2_matcher_->get_error();
                 }
             }
             break;
@@ -44,263 +117,1025 @@ GrepEngine::GrepEngine(const Options& options)
 }
 
 void GrepEngine::start_search() {
-    // Initialize worker threads
-    workers_.reserve(options_.threads);
-    for (int i = 0; i < options_.threads; ++i) {
-        workers_.emplace_back(&GrepEngine::worker_thread, this);
+    size_t num_workers = pool_.size();
+    
+    if (!options_.index_path.empty() && !index_) {
+        load_index();
     }
 
-    // Scan files and push to the queue
-    scanner_.scan(options_.paths, [this](const FileInfo& file_info) {
+    // Sorting only matters for printed lines, and -q prints none
+    if (options_.sort_files && !options_.quiet) {
+        // Walk in sorted order on this thread and number the files; workers
+        // search them in parallel and the reorder buffer prints in order
+        // Nothing of an earlier sorted search may carry over: its end flag
+        // would let workers quit before this walk is done
+        walk_done_.store(false, std::memory_order_release);
+        ordered_paths_.clear();
+        
+        const size_t window = num_workers * kReorderWindowPerThread;
+        reorder_ = std::make_unique<ReorderBuffer>([this](const std::string& batch) {
+            output_.write(batch);
+        }, window);
+        ordered_files_ = std::make_unique<MpmcQueue<OrderedFile>>(window);
+
+        pool_.start([this](size_t) { ordered_worker(); });
+
+        size_t sequence = 0;
+        scanner_.scan(options_.paths, [&](const FileInfo& file_info) {
+            reorder_->wait_for_slot(sequence);
+            OrderedFile file;
+            file.path = ordered_paths_.store(file_info.path);
+            file.length = static_cast<uint32_t>(file_info.path.size());
+            file.sequence = sequence++;
+            // The ring holds a whole window, so this only retries if a
+            // consumer is still mid-pop on a freed cell
+            while (!ordered_files_->try_push(file)) {
+                std::this_thread::yield();
+            }
+            wake_ordered_worker();
+        });
         {
-            std::lock_guard<std::mutex> lock(queue_mutex_);
-            file_queue_.push(file_info);
+            std::lock_guard<std::mutex> lock(ordered_mutex_);
+            walk_done_.store(true, std::memory_order_release);
+        }
+        ordered_cv_.notify_all();
+        return;
+    }
+
+    // Workers walk the directory tree themselves, stealing subtrees from
+    // each other, and print each file's results as soon as it is searched
+    walker_ = std::make_unique<ParallelWalker>(scanner_, options_, num_workers, cancel_);
+    walker_->seed(options_.paths);
+    pool_.start([this](size_t worker) { walk_worker(worker); });
+}
+
+SearchSummary GrepEngine::search(const std::vector<std::string>& paths, SearchSink& sink) {
+    SearchSummary summary;
+    if (!is_valid()) {
+        sink.error(std::string_view(), error_);
+        summary.errors = 1;
+        return summary;
+    }
+    
+    reset_search();
+    sink_ = &sink;
+    scanner_.set_diagnostic_handlers(
+        [this](const std::string& path, const std::string& message) { sink_->warning(path, message); },
+        [this](const std::string& path, const std::string& message) { report_read_error(path, message); });
+    if (!options_.index_path.empty() && !index_) {
+        load_index();
+    }
+    
+    walker_ = std::make_unique<ParallelWalker>(scanner_, options_, pool_.size(), cancel_);
+    walker_->seed(paths);
+    pool_.start([this](size_t worker) { walk_worker(worker); });
+    stop_search();
+    walker_.reset();
+    scanner_.save_cache();
+    scanner_.set_diagnostic_handlers(nullptr, nullptr);
+    sink_ = nullptr;
+    
+    summary.files_searched = files_searched_.load();
+    summary.files_matched = files_matched_.load();
+    summary.matched_lines = match_count_.load();
+    summary.matches = matches_found_.load();
+    summary.bytes_searched = bytes_searched_.load();
+    summary.errors = errors_.load();
+    // -q stops the search itself after the first match; that stop is not
+    // a cancellation and must not carry over to the next search
+    if (stopped_by_quiet_.exchange(false)) {
+        cancel_.reset();
+    }
+    summary.cancelled = cancel_.is_cancelled();
+    return summary;
+}
+
+void GrepEngine::reset_search() {
+    match_count_ = 0;
+    files_searched_ = 0;
+    bytes_searched_ = 0;
+    split_files_ = 0;
+    split_chunks_ = 0;
+    index_skipped_ = 0;
+    matches_found_ = 0;
+    files_matched_ = 0;
+    errors_ = 0;
+}
+
+void GrepEngine::walk_worker(size_t worker) {
+    if (options_.io_backend == IoBackend::IO_URING) {
+        uring_worker(worker);
+        return;
+    }
+    walker_->work(worker, [this](std::string_view path) {
+        std::string batch = process_file(path);
+        if (!batch.empty()) {
+            output_.write(batch);
         }
-        queue_cv_.notify_one();
     });
+}
 
-    // Signal that scanning is done
-    done_.store(true);
-    queue_cv_.notify_all();
+void GrepEngine::uring_worker(size_t worker) {
+    // Files handed to this worker are only submitted; it searches whichever
+    // reads complete, so up to kUringDepth opens and reads stay in flight
+    UringReader reader(kUringDepth, FileScanner::kMaxMappedSize);
+    std::vector<UringReader::Completed> completed;
+    
+    auto search_completed = [&] {
+        for (auto& file : completed) {
+            std::string batch;
+            const std::string_view contents = file.contents.view();
+            const bool gzip = options_.search_zip && contents.size() >= 2 &&
+                              static_cast<unsigned char>(contents[0]) == 0x1f &&
+                              static_cast<unsigned char>(contents[1]) == 0x8b;
+            if (file.too_large || gzip) {
+                batch = process_file(file.path);   // streamed synchronously
+            } else if (file.error != 0) {
+                report_read_error(file.path, std::strerror(file.error));
+            } else {
+                batch = search_file(file.path, scanner_.filter_binary(std::move(file.contents)), nullptr);
+            }
+            if (!batch.empty()) {
+                output_.write(batch);
+            }
+        }
+        completed.clear();
+    };
+    
+    walker_->work(worker, [&](std::string_view path) {
+        if (cancel_.is_cancelled() || skipped_by_index(path)) {
+            return;
+        }
+        if (!reader.submit(std::string(path))) {
+            // Pipeline full: finish at least one file to free a slot
+            reader.reap(completed, true);
+            search_completed();
+            if (!reader.submit(std::string(path))) {
+                std::string batch = process_file(path);
+                if (!batch.empty()) {
+                    output_.write(batch);
+                }
+                return;
+            }
+        }
+        reader.reap(completed, false);
+        search_completed();
+    }, [&] {
+        // Nothing left to walk right now: finish the reads in flight
+        if (reader.in_flight() == 0) {
+            return false;
+        }
+        reader.reap(completed, true);
+        search_completed();
+        return true;
+    });
+    
+    while (reader.in_flight() > 0) {
+        reader.reap(completed, true);
+        search_completed();
+    }
 }
 
-void GrepEngine::stop_search() {
-    for (auto& worker : workers_) {
-        if (worker.joinable()) {
-            worker.join();
+void GrepEngine::ordered_worker() {
+    while (true) {
+        OrderedFile file;
+        if (ordered_files_->try_pop(file)) {
+            reorder_->submit(file.sequence, process_file(std::string_view(file.path, file.length)));
+            continue;
         }
+        
+        if (walk_done_.load(std::memory_order_acquire) && ordered_files_->empty()) {
+            return;
+        }
+        
+        // The walk is still producing: sleep until it queues a file or ends
+        std::unique_lock<std::mutex> lock(ordered_mutex_);
+        ordered_parked_.fetch_add(1, std::memory_order_seq_cst);
+        // Pairs with the fence in wake_ordered_worker: either the walk sees
+        // this worker parked, or this check sees the queued file
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        ordered_cv_.wait(lock, [this] {
+            return walk_done_.load(std::memory_order_acquire) || !ordered_files_->empty();
+        });
+        ordered_parked_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+void GrepEngine::wake_ordered_worker() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (ordered_parked_.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(ordered_mutex_);
+        ordered_cv_.notify_one();
     }
 }
 
+void GrepEngine::stop_search() {
+    pool_.wait();
+}
+
 int GrepEngine::search() {
+    if (options_.build_index) {
+        return build_index();
+    }
+    
+    const auto start = std::chrono::steady_clock::now();
+    
     // Start the search
+    reset_search();
     start_search();
 
     // Wait for all workers to finish
     stop_search();
+    scanner_.save_cache();
+    if (options_.json && !options_.quiet) {
+        write_json_summary(std::chrono::steady_clock::now() - start);
+    }
+    output_.flush();
 
-    // Print results
-    if (!options_.quiet) {
-        if (options_.count_only) {
-            std::cout << match_count_.load() << "\n";
-        } else {
-            // Sort results for consistent output
-            std::sort(results_.begin(), results_.end(),
-                      [](const SearchResult& a, const SearchResult& b) {
-                          if (a.file_path != b.file_path) {
-                              return a.file_path < b.file_path;
-                          }
-                          return a.line_number < b.line_number;
-                      });
-
-            for (const auto& result : results_) {
-                print_result(result);
-            }
-        }
+    // Matching lines were printed as each file finished
+    if (!options_.quiet && options_.count_only) {
+        std::cout << match_count_.load() << "\n";
+    }
+    
+    if (options_.stats) {
+        print_stats();
     }
 
     return match_count_.load() > 0 ? 0 : 1;
 }
 
-void GrepEngine::worker_thread() {
-    while (true) {
-        FileInfo file_info;
-        
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            queue_cv_.wait(lock, [this] { 
-                return !file_queue_.empty() || done_.load(); 
-            });
-            
-            if (file_queue_.empty() && done_.load()) {
-                break;
+std::string GrepEngine::process_file(std::string_view path) {
+    if (cancel_.is_cancelled() || skipped_by_index(path)) {
+        return std::string();
+    }
+    
+    const std::string file_path(path);
+    
+    // With splitting on, large files are mapped whole rather than streamed
+    // so their pieces can be searched in parallel
+    std::unique_ptr<ChunkReader> stream;
+    FileBuffer buffer;
+    try {
+        buffer = scanner_.read_file(file_path, &stream,
+                                    can_split() ? SIZE_MAX : FileScanner::kMaxMappedSize);
+    } catch (const std::exception& e) {
+        report_read_error(file_path, e.what());
+        return std::string();
+    }
+    
+    return search_file(file_path, std::move(buffer), stream.get());
+}
+
+std::string GrepEngine::search_file(const std::string& file_path, FileBuffer buffer, ChunkReader* stream) {
+    std::string output;
+    const size_t limit = line_limit();
+    size_t matched_lines = 0;
+    size_t matches = 0;
+    size_t file_bytes = 0;
+    
+    // Lines are counted here, once the results are final: a split file's
+    // pieces each search up to the limit before being merged and truncated
+    auto collect = [&](const std::vector<SearchResult>& results) {
+        matched_lines += results.size();
+        match_count_.fetch_add(results.size());
+        if (sink_) {
+            for (const auto& result : results) {
+                matches += result.matches.size();
+                sink_->match(SinkMatch{file_path, result.line_content, result.line_number,
+                                       result.byte_offset, result.matches});
             }
-            
-            if (!file_queue_.empty()) {
-                file_info = file_queue_.front();
-                file_queue_.pop();
+            return;
+        }
+        if (options_.quiet || options_.files_with_matches || options_.count_only) {
+            return;
+        }
+        for (const auto& result : results) {
+            if (options_.json) {
+                if (output.empty()) {
+                    format_json_begin(file_path, output);
+                }
+                matches += result.matches.size();
+                format_json(result, output);
+            } else {
+                format_output(result, output);
             }
+            output += '\n';
         }
-        
-        if (file_info.path.empty()) {
-            continue;
+    };
+    
+    files_searched_.fetch_add(1, std::memory_order_relaxed);
+    if (sink_) {
+        sink_->begin_file(file_path);
+    }
+    try {
+        if (!stream) {
+            file_bytes = buffer.size();
+            if (can_split() && buffer.size() > options_.split_threshold) {
+                collect(search_in_parallel(file_path, buffer.view(), limit));
+            } else {
+                collect(search_in_content(file_path, buffer.view(), 1, 0, limit));
+            }
+        } else {
+            // Large file: search one block of whole lines at a time, carrying
+            // the line number across blocks
+            std::string_view chunk;
+            size_t first_line = 1;
+            bool at_file_start = true;
+            while (matched_lines < limit && !cancel_.is_cancelled() && stream->next(chunk)) {
+                size_t length = scanner_.searchable_length(chunk, at_file_start);
+                at_file_start = false;
+                
+                collect(search_in_content(file_path, chunk.substr(0, length), first_line, file_bytes,
+                                          limit - matched_lines));
+                file_bytes += length;
+                if (length < chunk.size()) {
+                    break; // binary contents
+                }
+                if (need_line_numbers()) {
+                    first_line += simd::count_newlines(chunk);
+                }
+            }
         }
-        
-        process_file(file_info);
+    } catch (const std::exception& e) {
+        report_read_error(file_path, e.what());
+    }
+    bytes_searched_.fetch_add(file_bytes, std::memory_order_relaxed);
+    if (sink_) {
+        sink_->end_file(file_path, FileSearchStats{matched_lines, matches, file_bytes});
     }
+    
+    if (matched_lines > 0) {
+        files_matched_.fetch_add(1, std::memory_order_relaxed);
+        matches_found_.fetch_add(matches, std::memory_order_relaxed);
+        if (options_.json && !output.empty()) {
+            format_json_end(file_path, matched_lines, matches, file_bytes, output);
+            output += '\n';
+        }
+        if (options_.quiet) {
+            // Any match decides the exit status; nothing else needs searching
+            stopped_by_quiet_.store(true);
+            cancel_.cancel();
+        } else if (options_.files_with_matches && !sink_) {
+            output.clear();
+            append_colored(output, file_path, kColorPath);
+            output += '\n';
+        }
+    }
+    return output;
 }
 
-void GrepEngine::process_file(const FileInfo& file_info) {
-    try {
-        std::string content = scanner_.read_file(file_info.path);
-        auto file_results = search_in_content(file_info.path, content);
+int GrepEngine::build_index() {
+    // Index everything after the first NUL too, and the contents of gzip
+    // files, so the index serves searches with or without those options
+    options_.stop_at_nul = false;
+#ifdef HAVE_ZLIB
+    options_.search_zip = true;
+#endif
+    
+    std::string error;
+    std::unique_ptr<TrigramIndex> previous;
+    if (std::filesystem::exists(options_.index_path)) {
+        previous = TrigramIndex::open(options_.index_path, error);
+        if (!previous) {
+            std::cerr << "Warning: Rebuilding index: " << error << "\n";
+        }
+    }
+    
+    // Walk exactly as a search would, so the same files are indexed
+    TrigramIndexBuilder builder(previous.get());
+    walker_ = std::make_unique<ParallelWalker>(scanner_, options_, pool_.size(), cancel_);
+    walker_->seed(options_.paths);
+    pool_.start([this, &builder](size_t worker) {
+        TrigramCollector collector;
+        walker_->work(worker, [&](std::string_view path) {
+            index_file(path, builder, collector);
+        });
+    });
+    stop_search();
+    scanner_.save_cache();
+    
+    if (!builder.write(options_.index_path, error)) {
+        std::cerr << "Error: Cannot write index: " << error << "\n";
+        return 1;
+    }
+    std::cout << "Indexed " << builder.reused_count() + builder.added_count() << " files into "
+              << options_.index_path << " (" << builder.added_count() << " read, "
+              << builder.reused_count() << " unchanged)\n";
+    return 0;
+}
 
-        for (const auto& result : file_results) {
-            add_result(result);
+void GrepEngine::index_file(std::string_view path, TrigramIndexBuilder& builder, TrigramCollector& collector) {
+    const std::string file_path(path);
+    
+    // Stamp before reading: a file changed meanwhile is re-read next time
+    auto stamp = FileStamp::of(file_path);
+    if (!stamp) {
+        report_read_error(file_path, std::strerror(errno));
+        return;
+    }
+    if (builder.reuse(file_path, *stamp)) {
+        return;
+    }
+    
+    try {
+        std::unique_ptr<ChunkReader> stream;
+        FileBuffer buffer = scanner_.read_file(file_path, &stream);
+        if (!stream) {
+            collector.add(buffer.view());
+        } else {
+            std::string_view chunk;
+            bool at_file_start = true;
+            while (stream->next(chunk)) {
+                size_t length = scanner_.searchable_length(chunk, at_file_start);
+                at_file_start = false;
+                collector.add(chunk.substr(0, length));
+                if (length < chunk.size()) {
+                    break; // binary contents
+                }
+            }
         }
     } catch (const std::exception& e) {
-        if (!options_.quiet) {
-            std::cerr << "Error reading file " << file_info.path << ": " << e.what() << "\n";
+        collector.take();
+        report_read_error(file_path, e.what());
+        return;
+    }
+    
+    builder.add(file_path, *stamp, collector.take());
+}
+
+void GrepEngine::load_index() {
+    std::string error;
+    index_ = TrigramIndex::open(options_.index_path, error);
+    if (!index_) {
+        if (sink_) {
+            sink_->warning(options_.index_path, "not using index: " + error);
+        } else {
+            std::cerr << "Warning: Not using index: " << error << "\n";
+        }
+        return;
+    }
+    
+    TrigramQuery query = TrigramQuery::plan(options_);
+    if (query.match_all) {
+        // The patterns give the index nothing to filter on
+        index_.reset();
+        return;
+    }
+    index_candidates_ = index_->candidates(query);
+}
+
+bool GrepEngine::skipped_by_index(std::string_view path) {
+    if (!index_) {
+        return false;
+    }
+    
+    const uint32_t id = index_->find(path);
+    if (id == TrigramIndex::kNoFile || index_candidates_[id]) {
+        return false;
+    }
+    
+    // Only an unchanged file is known not to match
+    auto stamp = FileStamp::of(std::string(path));
+    if (!stamp || !(*stamp == index_->stamp(id))) {
+        return false;
+    }
+    index_skipped_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool GrepEngine::can_split() const {
+    // Splitting needs the whole file mapped and other workers to help
+    return walker_ && options_.split_threshold > 0 && options_.threads > 1 &&
+           options_.io_backend == IoBackend::MMAP && sizeof(void*) >= 8;
+}
+
+void GrepEngine::report_read_error(const std::string& file_path, const std::string& message) {
+    if (sink_) {
+        errors_.fetch_add(1, std::memory_order_relaxed);
+        sink_->error(file_path, message);
+    } else if (!options_.quiet) {
+        std::cerr << "Error reading file " << file_path << ": " << message << "\n";
+    }
+}
+
+std::vector<SearchResult> GrepEngine::search_in_parallel(const std::string& file_path,
+                                                        std::string_view content, size_t max_lines) {
+    // Cut the buffer into line-aligned pieces, a few per thread so uneven
+    // match density still balances out
+    const size_t threads = static_cast<size_t>(options_.threads);
+    const size_t target = std::max(kMinSplitChunk, content.size() / (threads * 4));
+    
+    auto job = std::make_shared<SplitJob>();
+    job->content = content;
+    job->boundaries.push_back(0);
+    for (size_t cut = target; cut < content.size(); cut += target) {
+        size_t newline = content.find('\n', cut);
+        if (newline == std::string_view::npos || newline + 1 >= content.size()) {
+            break;
+        }
+        job->boundaries.push_back(newline + 1);
+        cut = newline + 1;
+    }
+    job->boundaries.push_back(content.size());
+    
+    const size_t pieces = job->boundaries.size() - 1;
+    job->results.resize(pieces);
+    job->newlines.resize(pieces);
+    split_files_.fetch_add(1, std::memory_order_relaxed);
+    split_chunks_.fetch_add(pieces, std::memory_order_relaxed);
+    
+    // Owner and helpers claim pieces from a shared counter until none are left
+    auto run = [this, job, &file_path, max_lines] {
+        for (size_t i = job->next.fetch_add(1); i < job->results.size(); i = job->next.fetch_add(1)) {
+            std::string_view piece = job->content.substr(job->boundaries[i],
+                                                         job->boundaries[i + 1] - job->boundaries[i]);
+            job->results[i] = search_in_content(file_path, piece, 1, job->boundaries[i], max_lines);
+            if (need_line_numbers()) {
+                job->newlines[i] = simd::count_newlines(piece);
+            }
+            job->done.fetch_add(1, std::memory_order_release);
+        }
+    };
+    // Helpers that start after the owner has returned find nothing to claim,
+    // so they never touch file_path or the buffer
+    for (size_t i = 1; i < std::min(threads, pieces); ++i) {
+        walker_->spawn([job, run] { run(); });
+    }
+    run();
+    while (job->done.load(std::memory_order_acquire) < pieces) {
+        std::this_thread::yield();
+    }
+    
+    // Piece-relative line numbers plus the prefix sum of earlier newlines
+    std::vector<SearchResult> results;
+    size_t line_base = 0;
+    for (size_t i = 0; i < pieces && results.size() < max_lines; ++i) {
+        for (auto& result : job->results[i]) {
+            if (results.size() == max_lines) {
+                break;
+            }
+            if (result.line_number > 0) {
+                result.line_number += line_base;
+            }
+            results.push_back(std::move(result));
         }
+        line_base += job->newlines[i];
+    }
+    return results;
+}
+
+bool GrepEngine::need_line_numbers() const {
+    // Line numbers are never shown with -c, -q, -l or --no-line-number, so
+    // the newline counting between matches is skipped altogether; --json
+    // always reports them
+    return (options_.show_line_number || options_.json) && !options_.count_only &&
+           !options_.quiet && !options_.files_with_matches;
+}
+
+size_t GrepEngine::line_limit() const {
+    // -q and -l only need to know whether a file matches, -m caps the lines
+    if (options_.quiet || options_.files_with_matches) {
+        return 1;
+    }
+    if (options_.max_count >= 0) {
+        return static_cast<size_t>(options_.max_count);
+    }
+    return SIZE_MAX;
+}
+
+namespace {
+
+// Line containing `pos`, without its '\n' terminator. `floor` is a known line
+// start at or before `pos` that bounds the backwards scan.
+std::string_view line_at(std::string_view content, size_t floor, size_t pos,
+                         size_t& line_start, size_t& line_end) {
+    line_start = pos;
+    while (line_start > floor && content[line_start - 1] != '\n') {
+        --line_start;
     }
+    line_end = content.find('\n', pos);
+    if (line_end == std::string_view::npos) {
+        line_end = content.size();
+    }
+    
+    std::string_view line = content.substr(line_start, line_end - line_start);
+    // Remove carriage return if present
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    return line;
 }
 
+} // namespace
+
 std::vector<SearchResult> GrepEngine::search_in_content(const std::string& file_path, 
-                                                       const std::string& content) {
+                                                       std::string_view content,
+                                                       size_t first_line, size_t first_offset,
+                                                       size_t max_lines) {
     std::vector<SearchResult> results;
-    auto lines = scanner_.get_lines(content);
     
-    for (const auto& line : lines) {
-        bool matched = false;
+    // The matcher runs over the whole buffer; lines are only located (and
+    // line numbers only counted) around the matches it reports.
+    size_t pos = 0;              // start of the first line not yet examined
+    size_t counted_pos = 0;      // offset up to which newlines have been counted
+    size_t counted_line = first_line;  // line number at counted_pos
+    const bool count_lines = need_line_numbers();
+    
+    auto line_number_at = [&](size_t offset) -> size_t {
+        if (!count_lines) {
+            return 0;
+        }
+        counted_line += simd::count_newlines(content.substr(counted_pos, offset - counted_pos));
+        counted_pos = offset;
+        return counted_line;
+    };
+    
+    auto emit = [&](size_t line_start, std::string_view line, std::vector<Match>&& matches) {
+        SearchResult result;
+        result.file_path = file_path;
+        result.line_number = line_number_at(line_start);
+        result.byte_offset = first_offset + line_start;
+        result.line_content = std::string(line);
+        result.matches = std::move(matches);
+        result.matched = true;
+        
+        results.push_back(std::move(result));
+    };
+    
+    // Over the whole buffer '$' only anchors before '\n', so with CRLF
+    // endings every line is checked on its own, without its '\r'; \A, \z
+    // and \Z anchor at the ends of a line only when it is the whole subject
+    const bool check_every_line = anchors_subject_ ||
+                                  (anchors_line_end_ && content.find('\r') != std::string_view::npos);
+    
+    // A rule set is matched against the whole buffer once; the cursor then
+    // only searches with the rules that fired. A split PCRE2 set keeps each
+    // program's next match the same way.
+    std::optional<RE2SetMatcher::Cursor> rule_cursor;
+    std::optional<RegexSetMatcher::Cursor> program_cursor;
+    if (re2_set_matcher_ && !check_every_line) {
+        rule_cursor.emplace(re2_set_matcher_->scan(content));
+    } else if (pcre2_set_matcher_ && !check_every_line) {
+        program_cursor.emplace(pcre2_set_matcher_->scan(content));
+    }
+    
+    while (pos < content.size() && results.size() < max_lines && !cancel_.is_cancelled()) {
+        // Find the next line that actually matches, verifying each candidate
+        // against its own line so matches never span line boundaries
+        size_t match_start = content.size();
+        size_t match_end = content.size();
+        std::string_view matched_line;
         std::vector<Match> matches;
         
-        // Determine if line matches based on search mode
-        switch (options_.mode) {
-            case SearchMode::LITERAL:
-                matched = RegexMatcher::literal_match(line.content, options_.pattern, options_.ignore_case);
-                if (matched) {
-                    // Create a simple match for literal search
-                    size_t pos = options_.ignore_case ? 
-                        line.content.find(options_.pattern) :
-                        line.content.find(options_.pattern);
-                    if (pos != std::string::npos) {
-                        Match match;
-                        match.start = pos;
-                        match.end = pos + options_.pattern.length();
-                        match.text = options_.pattern;
-                        matches.push_back(match);
-                    }
-                }
+        for (size_t scan = pos; scan < content.size();) {
+            std::optional<MatchRange> candidate;
+            if (check_every_line) {
+                candidate = MatchRange{scan, scan};
+            } else {
+                candidate = rule_cursor ? rule_cursor->next(scan)
+                          : program_cursor ? program_cursor->next(scan)
+                          : find_next_match(content, scan);
+            }
+            if (!candidate) {
                 break;
-                
-            case SearchMode::REGEX:
-            case SearchMode::CASE_INSENSITIVE:
-                if (options_.regex_engine == RegexEngine::RE2 && re2_matcher_) {
-                    matches = re2_matcher_->find_all(line.content);
-                    matched = !matches.empty();
-                } else if (pcre2_matcher_) {
-                    matches = pcre2_matcher_->find_all(line.content);
-                    matched = !matches.empty();
-                }
+            }
+            // An empty match past the final newline is not on any line
+            if (candidate->start >= content.size() && content.back() == '\n') {
                 break;
-        }
-        
-        // Apply word/line match constraints
-        if (matched) {
-            if (options_.word_match) {
-                // TODO: Implement word boundary checking
-                // For now, just check if it's surrounded by word boundaries
             }
             
-            if (options_.line_match) {
-                // Check if the entire line matches
-                if (options_.regex_engine == RegexEngine::RE2 && re2_matcher_) {
-                    matched = re2_matcher_->matches(line.content);
-                } else if (pcre2_matcher_) {
-                    matched = pcre2_matcher_->matches(line.content);
-                } else {
-                    matched = (line.content == options_.pattern);
-                }
+            size_t line_start, line_end;
+            std::string_view line = line_at(content, scan, candidate->start, line_start, line_end);
+            if (match_line(line, matches)) {
+                match_start = line_start;
+                match_end = line_end;
+                matched_line = line;
+                break;
             }
+            scan = line_end + 1;
         }
         
-        // Apply invert match
         if (options_.invert_match) {
-            matched = !matched;
+            // Every line before the matching one is a result
+            while (pos < match_start && results.size() < max_lines) {
+                size_t line_start, line_end;
+                std::string_view line = line_at(content, pos, pos, line_start, line_end);
+                emit(line_start, line, {});
+                pos = line_end + 1;
+            }
+        } else if (match_start < content.size()) {
+            emit(match_start, matched_line, std::move(matches));
         }
         
-        if (matched) {
-            SearchResult result;
-            result.file_path = file_path;
-            result.line_number = line.line_number;
-            result.line_content = line.content;
-            result.matches = matches;
-            result.matched = true;
+        pos = match_end + 1;
+    }
+    
+    return results;
+}
+
+std::optional<MatchRange> GrepEngine::find_next_match(std::string_view content, size_t from) const {
+    switch (options_.mode) {
+        case SearchMode::LITERAL: {
+            size_t pos = literal_searcher_->find(content, from);
+            if (pos == LiteralSearcher::npos) {
+                return std::nullopt;
+            }
+            return MatchRange{pos, pos + literal_searcher_->size()};
+        }
             
-            results.push_back(result);
-            match_count_.fetch_add(1);
+        case SearchMode::MULTI_LITERAL:
+            return multi_literal_matcher_->find_next(content, from);
+            
+        case SearchMode::REGEX:
+        case SearchMode::CASE_INSENSITIVE:
+            if (options_.regex_engine == RegexEngine::RE2 && re2_matcher_) {
+                return re2_matcher_->find_next(content, from);
+            } else if (pcre2_set_matcher_) {
+                return pcre2_set_matcher_->find_next(content, from);
+            } else if (pcre2_matcher_) {
+                return pcre2_matcher_->find_next(content, from);
+            }
+            break;
+    }
+    
+    return std::nullopt;
+}
+
+bool GrepEngine::match_line(std::string_view line, std::vector<Match>& matches) const {
+    matches.clear();
+    
+    // Determine if line matches based on search mode
+    switch (options_.mode) {
+        case SearchMode::LITERAL:
+            for (size_t pos : literal_searcher_->find_all(line)) {
+                Match match;
+                match.start = pos;
+                match.end = pos + literal_searcher_->size();
+                match.text = options_.pattern;
+                matches.push_back(match);
+            }
+            break;
+            
+        case SearchMode::MULTI_LITERAL:
+            matches = multi_literal_matcher_->find_all(line);
+            break;
+            
+        case SearchMode::REGEX:
+        case SearchMode::CASE_INSENSITIVE:
+            if (options_.regex_engine == RegexEngine::RE2 && re2_set_matcher_) {
+                matches = re2_set_matcher_->find_all(line);
+            } else if (options_.regex_engine == RegexEngine::RE2 && re2_matcher_) {
+                matches = re2_matcher_->find_all(line);
+            } else if (pcre2_set_matcher_) {
+                matches = pcre2_set_matcher_->find_all(line);
+            } else if (pcre2_matcher_) {
+                matches = pcre2_matcher_->find_all(line);
+            }
+            break;
+    }
+    
+    bool matched = !matches.empty();
+    
+    // Apply word/line match constraints
+    if (matched) {
+        if (options_.word_match) {
+            // TODO: Implement word boundary checking
+            // For now, just check if it's surrounded by word boundaries
+        }
+        
+        if (options_.line_match) {
+            // Check if the entire line matches
+            if (options_.regex_engine == RegexEngine::RE2 && re2_set_matcher_) {
+                matched = re2_set_matcher_->matches(line);
+            } else if (options_.regex_engine == RegexEngine::RE2 && re2_matcher_) {
+                matched = re2_matcher_->matches(line);
+            } else if (pcre2_set_matcher_) {
+                matched = pcre2_set_matcher_->matches(line);
+            } else if (pcre2_matcher_) {
+                matched = pcre2_matcher_->matches(line);
+            } else if (multi_literal_matcher_) {
+                matched = multi_literal_matcher_->matches(line);
+            } else {
+                matched = (line == options_.pattern);
+            }
         }
     }
     
-    return results;
+    return matched;
 }
 
-void GrepEngine::add_result(const SearchResult& result) {
-    std::lock_guard<std::mutex> lock(results_mutex_);
-    results_.push_back(result);
+namespace {
+
+const char* io_backend_name(IoBackend backend) {
+    switch (backend) {
+        case IoBackend::PREAD:
+            return "pread";
+        case IoBackend::IO_URING:
+            return "io_uring";
+        case IoBackend::MMAP:
+        default:
+            return "mmap";
+    }
 }
 
-void GrepEngine::print_result(const SearchResult& result) const {
-    std::cout << format_output(result) << "\n";
+} // namespace
+
+void GrepEngine::print_stats() const {
+    std::cout << "\n"
+              << "Files searched: " << files_searched_.load() << "\n"
+              << "Bytes searched: " << bytes_searched_.load() << "\n"
+              << "Matched lines: " << match_count_.load() << "\n"
+              << "I/O backend: " << io_backend_name(options_.io_backend) << "\n"
+              << "Split threshold: ";
+    if (options_.split_threshold > 0) {
+        std::cout << options_.split_threshold << " bytes\n";
+    } else {
+        std::cout << "disabled\n";
+    }
+    std::cout << "Files split: " << split_files_.load() << " (" << split_chunks_.load() << " pieces)\n";
+    if (!options_.index_path.empty()) {
+        std::cout << "Files skipped by index: " << index_skipped_.load() << "\n";
+    }
+    if (const MetadataCache* cache = scanner_.cache()) {
+        std::cout << "Binary files skipped by cache: " << cache->binary_skips() << "\n";
+    }
 }
 
-std::string GrepEngine::format_output(const SearchResult& result) const {
-    std::ostringstream oss;
+void GrepEngine::format_output(const SearchResult& result, std::string& out) const {
+    char number[24];
     
     // Add filename if requested and multiple files
     if (options_.show_filename) {
-        oss << colorize(result.file_path, "blue") << ":";
+        append_colored(out, result.file_path, kColorPath);
+        out += ':';
     }
     
     // Add line number if requested
     if (options_.show_line_number) {
-        oss << colorize(std::to_string(result.line_number), "green") << ":";
+        char* end = std::to_chars(number, number + sizeof(number), result.line_number).ptr;
+        append_colored(out, std::string_view(number, end - number), kColorLineNumber);
+        out += ':';
     }
     
-    // Add line content
-    std::string line_content = result.line_content;
+    // Add index of the pattern that matched first if requested
+    if (options_.show_pattern_index && !result.matches.empty()) {
+        number[0] = '#';
+        char* end = std::to_chars(number + 1, number + sizeof(number),
+                                  result.matches.front().pattern_index).ptr;
+        append_colored(out, std::string_view(number, end - number), kColorPatternIndex);
+        out += ':';
+    }
     
-    // Highlight matches if color is enabled
-    if (options_.color && (*options_.color == "always" || 
-        (*options_.color == "auto" && 
-#ifdef _WIN32
-        _isatty(_fileno(stdout))
-#else
-        isatty(STDOUT_FILENO)
-#endif
-        ))) {
-        
-        // Sort matches by start position in reverse order to avoid offset issues
-        std::vector<Match> sorted_matches = result.matches;
-        std::sort(sorted_matches.begin(), sorted_matches.end(),
-                  [](const Match& a, const Match& b) { return a.start > b.start; });
-        
-        for (const auto& match : sorted_matches) {
-            std::string highlighted = colorize(match.text, "red");
-            line_content.replace(match.start, match.end - match.start, highlighted);
-        }
+    const std::string_view line = result.line_content;
+    if (!use_color_ || result.matches.empty()) {
+        out += line;
+        return;
     }
     
-    oss << line_content;
+    // Highlight matches by copying the line span by span, front to back
+    const std::vector<Match>* matches = &result.matches;
+    std::vector<Match> sorted;
+    auto by_start = [](const Match& a, const Match& b) { return a.start < b.start; };
+    if (!std::is_sorted(matches->begin(), matches->end(), by_start)) {
+        sorted = result.matches;
+        std::sort(sorted.begin(), sorted.end(), by_start);
+        matches = &sorted;
+    }
     
-    return oss.str();
+    size_t pos = 0;
+    for (const auto& match : *matches) {
+        if (match.start < pos || match.end > line.size()) {
+            continue;
+        }
+        out += line.substr(pos, match.start - pos);
+        append_colored(out, line.substr(match.start, match.end - match.start), kColorMatch);
+        pos = match.end;
+    }
+    out += line.substr(pos);
 }
 
-std::string GrepEngine::colorize(const std::string& text, const std::string& color) const {
-    if (!options_.color || *options_.color == "never") {
-        return text;
-    }
+void GrepEngine::format_json(const SearchResult& result, std::string& out) const {
+    const std::string_view line = result.line_content;
     
-    if (*options_.color == "auto" && 
-#ifdef _WIN32
-        !_isatty(_fileno(stdout))
-#else
-        !isatty(STDOUT_FILENO)
-#endif
-        ) {
-        return text;
+    JsonWriter json(out);
+    json.begin_object();
+    json.key("type");
+    json.string("match");
+    json.key("data");
+    json.begin_object();
+    json.key("path");
+    json.data(result.file_path);
+    json.key("lines");
+    json.data(line);
+    json.key("line_number");
+    json.number(result.line_number);
+    json.key("absolute_offset");
+    json.number(result.byte_offset);
+    json.key("submatches");
+    json.begin_array();
+    for (const auto& match : result.matches) {
+        if (match.end > line.size()) {
+            continue;
+        }
+        json.begin_object();
+        json.key("match");
+        json.data(line.substr(match.start, match.end - match.start));
+        json.key("start");
+        json.number(match.start);
+        json.key("end");
+        json.number(match.end);
+        if (options_.show_pattern_index) {
+            json.key("pattern");
+            json.number(match.pattern_index);
+        }
+        json.end_object();
     }
+    json.end_array();
+    json.end_object();
+    json.end_object();
+}
+
+void GrepEngine::format_json_begin(const std::string& file_path, std::string& out) const {
+    JsonWriter json(out);
+    json.begin_object();
+    json.key("type");
+    json.string("begin");
+    json.key("data");
+    json.begin_object();
+    json.key("path");
+    json.data(file_path);
+    json.end_object();
+    json.end_object();
+    out += '\n';
+}
+
+void GrepEngine::format_json_end(const std::string& file_path, size_t matched_lines, size_t matches,
+                                 size_t bytes_searched, std::string& out) const {
+    JsonWriter json(out);
+    json.begin_object();
+    json.key("type");
+    json.string("end");
+    json.key("data");
+    json.begin_object();
+    json.key("path");
+    json.data(file_path);
+    json.key("stats");
+    json.begin_object();
+    json.key("matched_lines");
+    json.number(matched_lines);
+    json.key("matches");
+    json.number(matches);
+    json.key("bytes_searched");
+    json.number(bytes_searched);
+    json.end_object();
+    json.end_object();
+    json.end_object();
+}
+
+void GrepEngine::write_json_summary(std::chrono::steady_clock::duration elapsed) {
+    const auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
     
-    std::string color_code;
-    if (color == "red") color_code = "\033[31m";
-    else if (color == "green") color_code = "\033[32m";
-    else if (color == "blue") color_code = "\033[34m";
-    else if (color == "yellow") color_code = "\033[33m";
-    else if (color == "magenta") color_code = "\033[35m";
-    else if (color == "cyan") color_code = "\033[36m";
-    else return text;
-    
-    return color_code + text + "\033[0m";
+    std::string out;
+    JsonWriter json(out);
+    json.begin_object();
+    json.key("type");
+    json.string("summary");
+    json.key("data");
+    json.begin_object();
+    json.key("elapsed");
+    json.begin_object();
+    json.key("secs");
+    json.number(static_cast<uint64_t>(nanos / 1000000000));
+    json.key("nanos");
+    json.number(static_cast<uint64_t>(nanos % 1000000000));
+    json.end_object();
+    json.key("stats");
+    json.begin_object();
+    json.key("searches");
+    json.number(files_searched_.load());
+    json.key("searches_with_match");
+    json.number(files_matched_.load());
+    json.key("bytes_searched");
+    json.number(bytes_searched_.load());
+    json.key("matched_lines");
+    json.number(match_count_.load());
+    json.key("matches");
+    json.number(matches_found_.load());
+    json.end_object();
+    json.end_object();
+    json.end_object();
+    out += '\n';
+    output_.write(out);
+}
+
+void GrepEngine::append_colored(std::string& out, std::string_view text, const char* color_code) const {
+    if (!use_color_) {
+        out += text;
+        return;
+    }
+    out += color_code;
+    out += text;
+    out += kColorReset;
 }
 
 } // namespace cpp_ripgrep
\ No newline at end of file
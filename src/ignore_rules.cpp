@@ -0,0 +1,114 @@
+#include "ignore_rules.hpp"
+#include <fstream>
+
+namespace cpp_ripgrep {
+
+IgnoreRules::Ptr IgnoreRules::load(const std::string& directory, const std::vector<std::string>& files,
+                                   Ptr parent) {
+    if (files.empty()) {
+        return parent;
+    }
+
+    std::shared_ptr<IgnoreRules> rules(new IgnoreRules(directory, parent));
+    for (const char* name : kIgnoreFiles) {
+        for (const auto& file : files) {
+            if (file == name) {
+                rules->add_file(directory + "/" + file);
+            }
+        }
+    }
+
+    if (rules->rules_.empty()) {
+        return parent;
+    }
+    return rules;
+}
+
+void IgnoreRules::add_file(const std::string& file_path) {
+    std::ifstream file(file_path);
+    std::string line;
+    while (std::getline(file, line)) {
+        add_line(line);
+    }
+}
+
+void IgnoreRules::add_line(std::string_view line) {
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+
+    // Trailing spaces are dropped unless escaped with a backslash
+    while (!line.empty() && line.back() == ' ' &&
+           !(line.size() >= 2 && line[line.size() - 2] == '\\')) {
+        line.remove_suffix(1);
+    }
+    if (line.empty() || line[0] == '#') {
+        return;
+    }
+
+    Rule rule;
+    if (line[0] == '!') {
+        rule.negated = true;
+        line.remove_prefix(1);
+    } else if (line[0] == '\\' && line.size() > 1 && (line[1] == '!' || line[1] == '#')) {
+        line.remove_prefix(1);
+    }
+
+    if (!line.empty() && line.back() == '/') {
+        rule.directory_only = true;
+        line.remove_suffix(1);
+    }
+
+    // A slash anywhere but the end ties the pattern to this directory
+    if (line.find('/') != std::string_view::npos) {
+        rule.anchored = true;
+        if (line[0] == '/') {
+            line.remove_prefix(1);
+        }
+    }
+    if (line.empty()) {
+        return;
+    }
+
+    rule.glob = Glob(std::string(line));
+    rules_.push_back(std::move(rule));
+}
+
+bool IgnoreRules::is_ignored(std::string_view path, bool is_directory) const {
+    for (const IgnoreRules* rules = this; rules; rules = rules->parent_.get()) {
+        Verdict verdict = rules->decide(path, is_directory);
+        if (verdict != Verdict::NONE) {
+            return verdict == Verdict::IGNORE;
+        }
+    }
+    return false;
+}
+
+IgnoreRules::Verdict IgnoreRules::decide(std::string_view path, bool is_directory) const {
+    // Entries below this directory were named by appending to base_
+    if (path.compare(0, base_.size(), base_) != 0) {
+        return Verdict::NONE;
+    }
+    std::string_view relative = path.substr(base_.size());
+    while (!relative.empty() && relative[0] == '/') {
+        relative.remove_prefix(1);
+    }
+
+    std::string_view name = relative;
+    size_t slash = name.rfind('/');
+    if (slash != std::string_view::npos) {
+        name.remove_prefix(slash + 1);
+    }
+
+    for (auto it = rules_.rbegin(); it != rules_.rend(); ++it) {
+        if (it->directory_only && !is_directory) {
+            continue;
+        }
+        if (it->glob.matches(it->anchored ? relative : name)) {
+            return it->negated ? Verdict::INCLUDE : Verdict::IGNORE;
+        }
+    }
+    return Verdict::NONE;
+}
+
+} // namespace cpp_ripgrep
@@ -0,0 +1,202 @@
+#include "json_writer.hpp"
+#include <charconv>
+
+namespace cpp_ripgrep {
+
+namespace {
+
+// Length of the UTF-8 sequence starting at text[i], or 0 if it is invalid
+size_t utf8_sequence_length(std::string_view text, size_t i) {
+    const unsigned char lead = static_cast<unsigned char>(text[i]);
+    size_t length;
+    unsigned char min_second = 0x80;
+    unsigned char max_second = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        if (lead == 0xE0) {
+            min_second = 0xA0;   // overlong
+        } else if (lead == 0xED) {
+            max_second = 0x9F;   // surrogates
+        }
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        if (lead == 0xF0) {
+            min_second = 0x90;   // overlong
+        } else if (lead == 0xF4) {
+            max_second = 0x8F;   // beyond U+10FFFF
+        }
+    } else {
+        return 0;
+    }
+    if (i + length > text.size()) {
+        return 0;
+    }
+
+    const unsigned char second = static_cast<unsigned char>(text[i + 1]);
+    if (second < min_second || second > max_second) {
+        return 0;
+    }
+    for (size_t k = 2; k < length; ++k) {
+        const unsigned char next = static_cast<unsigned char>(text[i + k]);
+        if (next < 0x80 || next > 0xBF) {
+            return 0;
+        }
+    }
+    return length;
+}
+
+// Bytes that cannot be copied into a JSON string as they are
+inline bool needs_care(unsigned char byte) {
+    return byte < 0x20 || byte == '"' || byte == '\\' || byte >= 0x80;
+}
+
+} // namespace
+
+void JsonWriter::separate() {
+    if (after_key_) {
+        after_key_ = false;
+        return;
+    }
+    const uint64_t bit = uint64_t(1) << (depth_ & 63);
+    if (has_items_ & bit) {
+        out_ += ',';
+    }
+    has_items_ |= bit;
+}
+
+void JsonWriter::begin_object() {
+    separate();
+    out_ += '{';
+    ++depth_;
+    has_items_ &= ~(uint64_t(1) << (depth_ & 63));
+}
+
+void JsonWriter::end_object() {
+    out_ += '}';
+    --depth_;
+}
+
+void JsonWriter::begin_array() {
+    separate();
+    out_ += '[';
+    ++depth_;
+    has_items_ &= ~(uint64_t(1) << (depth_ & 63));
+}
+
+void JsonWriter::end_array() {
+    out_ += ']';
+    --depth_;
+}
+
+void JsonWriter::key(std::string_view name) {
+    separate();
+    out_ += '"';
+    out_ += name;
+    out_ += "\":";
+    after_key_ = true;
+}
+
+void JsonWriter::string(std::string_view text) {
+    separate();
+    if (!append_string(text)) {
+        out_ += "\"\"";
+    }
+}
+
+void JsonWriter::number(uint64_t value) {
+    separate();
+    char digits[24];
+    char* end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+    out_.append(digits, end - digits);
+}
+
+void JsonWriter::null() {
+    separate();
+    out_ += "null";
+}
+
+void JsonWriter::data(std::string_view bytes) {
+    // The object has a single member, so its key needs no separator
+    begin_object();
+    const size_t mark = out_.size();
+    out_ += "\"text\":";
+    if (!append_string(bytes)) {
+        out_.resize(mark);
+        out_ += "\"bytes\":";
+        append_base64(bytes);
+    }
+    end_object();
+}
+
+bool JsonWriter::append_string(std::string_view text) {
+    static const char kHex[] = "0123456789abcdef";
+    const size_t mark = out_.size();
+    out_ += '"';
+
+    size_t run = 0;   // start of the bytes not yet copied
+    for (size_t i = 0; i < text.size();) {
+        const unsigned char byte = static_cast<unsigned char>(text[i]);
+        if (!needs_care(byte)) {
+            ++i;
+            continue;
+        }
+        if (byte >= 0x80) {
+            size_t length = utf8_sequence_length(text, i);
+            if (length == 0) {
+                out_.resize(mark);
+                return false;
+            }
+            i += length;   // valid multi-byte characters are copied as they are
+            continue;
+        }
+
+        out_.append(text.data() + run, i - run);
+        switch (byte) {
+            case '"':  out_ += "\\\""; break;
+            case '\\': out_ += "\\\\"; break;
+            case '\n': out_ += "\\n"; break;
+            case '\r': out_ += "\\r"; break;
+            case '\t': out_ += "\\t"; break;
+            default: {
+                const char escape[] = {'\\', 'u', '0', '0', kHex[byte >> 4], kHex[byte & 0xF]};
+                out_.append(escape, sizeof(escape));
+                break;
+            }
+        }
+        run = ++i;
+    }
+    out_.append(text.data() + run, text.size() - run);
+
+    out_ += '"';
+    return true;
+}
+
+void JsonWriter::append_base64(std::string_view bytes) {
+    static const char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    out_ += '"';
+
+    size_t i = 0;
+    for (; i + 3 <= bytes.size(); i += 3) {
+        const uint32_t group = (uint32_t(static_cast<unsigned char>(bytes[i])) << 16) |
+                               (uint32_t(static_cast<unsigned char>(bytes[i + 1])) << 8) |
+                               uint32_t(static_cast<unsigned char>(bytes[i + 2]));
+        const char quad[] = {kAlphabet[group >> 18], kAlphabet[(group >> 12) & 63],
+                             kAlphabet[(group >> 6) & 63], kAlphabet[group & 63]};
+        out_.append(quad, 4);
+    }
+    if (i < bytes.size()) {
+        uint32_t group = uint32_t(static_cast<unsigned char>(bytes[i])) << 16;
+        if (i + 1 < bytes.size()) {
+            group |= uint32_t(static_cast<unsigned char>(bytes[i + 1])) << 8;
+        }
+        const char quad[] = {kAlphabet[group >> 18], kAlphabet[(group >> 12) & 63],
+                             i + 1 < bytes.size() ? kAlphabet[(group >> 6) & 63] : '=', '='};
+        out_.append(quad, 4);
+    }
+
+    out_ += '"';
+}
+
+} // namespace cpp_ripgrep
@@ -0,0 +1,175 @@
+#include "literal_searcher.hpp"
+#include "simd_utils.hpp"
+#include <cstring>
+
+#ifdef CPP_RIPGREP_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace cpp_ripgrep {
+
+namespace {
+
+// Frequency rank of every byte value, measured over a mix of C/C++ headers,
+// scripts, documentation and system logs (files containing NUL excluded).
+// Space and lowercase vowels rank highest; control bytes and most of the
+// high half rank lowest.
+const uint8_t kByteRank[256] = {
+      0,   1,   2,   3,   4,   5,   6,  50,   7, 185, 245,   8,  71, 149,   9,  10,  // 0x00
+     11,  12,  13,  14,  15,  16,  17,  18,  19,  20,  21,  22,  23,  24,  25,  26,  // 0x10
+    255, 168, 193, 202, 169, 161, 186, 188, 228, 229, 221, 170, 239, 210, 215, 235,  // 0x20
+    225, 224, 211, 204, 197, 198, 195, 189, 190, 194, 236, 208, 212, 205, 216, 160,  // 0x30
+    167, 227, 201, 219, 203, 230, 196, 191, 182, 223, 166, 178, 214, 200, 218, 226,  // 0x40
+    213, 164, 217, 232, 234, 192, 181, 171, 187, 175, 163, 180, 177, 179, 159, 248,  // 0x50
+    173, 250, 220, 244, 241, 254, 237, 222, 233, 249, 174, 207, 243, 240, 251, 247,  // 0x60
+    242, 172, 246, 252, 253, 238, 209, 199, 206, 231, 176, 184, 165, 183, 162,  27,  // 0x70
+    152, 140, 135, 122, 102,  93, 103, 139, 136, 111,  80,  77, 101,  92,  82, 143,  // 0x80
+    120, 131, 106, 110, 150, 115, 145,  90, 114, 138, 113,  89, 134, 121,  86, 155,  // 0x90
+    133, 127,  87, 112, 128,  98, 104, 124, 100, 147,  84, 141,  83,  94,  97,  78,  // 0xA0
+    119, 118, 116, 109, 123, 117, 132,  96, 153, 137, 108, 107, 130, 129, 126, 105,  // 0xB0
+     28,  29, 144, 156,  76,  91,  57,  56,  60,  65,  62,  53,  64,  51, 148, 125,  // 0xC0
+    157, 146,  59,  58,  54,  61,  95, 142,  88,  85,  55,  52,  45,  30,  31,  32,  // 0xD0
+    151,  81, 158,  79,  69,  75,  74,  73,  72,  70,  68,  67,  66,  63,  33,  99,  // 0xE0
+    154,  34,  35,  46,  47,  36,  48,  37,  38,  39,  40,  41,  42,  49,  43,  44,  // 0xF0
+};
+
+#ifdef CPP_RIPGREP_X86_DISPATCH
+
+__attribute__((target("sse2")))
+size_t find_sse2(const char* haystack, size_t size, size_t& pos,
+                 const std::string& needle, size_t i1, size_t i2) {
+    const size_t n = needle.size();
+    const __m128i rare1 = _mm_set1_epi8(needle[i1]);
+    const __m128i rare2 = _mm_set1_epi8(needle[i2]);
+    
+    // Every one of the 16 candidates must have room for the whole needle
+    for (; pos + 15 + n <= size; pos += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + pos + i1));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + pos + i2));
+        unsigned mask = static_cast<unsigned>(
+            _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, rare1), _mm_cmpeq_epi8(b, rare2))));
+        while (mask) {
+            size_t candidate = pos + __builtin_ctz(mask);
+            if (std::memcmp(haystack + candidate, needle.data(), n) == 0) {
+                return candidate;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return LiteralSearcher::npos;
+}
+
+__attribute__((target("avx2")))
+size_t find_avx2(const char* haystack, size_t size, size_t& pos,
+                 const std::string& needle, size_t i1, size_t i2) {
+    const size_t n = needle.size();
+    const __m256i rare1 = _mm256_set1_epi8(needle[i1]);
+    const __m256i rare2 = _mm256_set1_epi8(needle[i2]);
+    
+    // Every one of the 32 candidates must have room for the whole needle
+    for (; pos + 31 + n <= size; pos += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(haystack + pos + i1));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(haystack + pos + i2));
+        unsigned mask = static_cast<unsigned>(
+            _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, rare1), _mm256_cmpeq_epi8(b, rare2))));
+        while (mask) {
+            size_t candidate = pos + __builtin_ctz(mask);
+            if (std::memcmp(haystack + candidate, needle.data(), n) == 0) {
+                return candidate;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return LiteralSearcher::npos;
+}
+
+#endif // CPP_RIPGREP_X86_DISPATCH
+
+} // namespace
+
+LiteralSearcher::LiteralSearcher(std::string needle) : needle_(std::move(needle)) {
+    // Pick the two rarest bytes at distinct positions of the needle
+    for (size_t i = 1; i < needle_.size(); ++i) {
+        if (byte_rank(needle_[i]) < byte_rank(needle_[rare1_index_])) {
+            rare1_index_ = i;
+        }
+    }
+    rare2_index_ = rare1_index_ == 0 ? 1 : 0;
+    for (size_t i = 0; i < needle_.size(); ++i) {
+        if (i != rare1_index_ && byte_rank(needle_[i]) < byte_rank(needle_[rare2_index_])) {
+            rare2_index_ = i;
+        }
+    }
+}
+
+uint8_t LiteralSearcher::byte_rank(unsigned char byte) {
+    return kByteRank[byte];
+}
+
+size_t LiteralSearcher::find(std::string_view haystack, size_t from) const {
+    const size_t n = needle_.size();
+    if (n == 0) {
+        return from <= haystack.size() ? from : npos;
+    }
+    if (from >= haystack.size() || haystack.size() - from < n) {
+        return npos;
+    }
+    
+    if (n == 1) {
+        const void* hit = std::memchr(haystack.data() + from, needle_[0], haystack.size() - from);
+        return hit ? static_cast<const char*>(hit) - haystack.data() : npos;
+    }
+    
+    // The vector loops stop short of the tail, which is finished in scalar code
+    size_t pos = from;
+#ifdef CPP_RIPGREP_X86_DISPATCH
+    size_t found = npos;
+    switch (simd::cpu_level()) {
+        case simd::Level::AVX2:
+            found = find_avx2(haystack.data(), haystack.size(), pos, needle_, rare1_index_, rare2_index_);
+            break;
+        case simd::Level::SSE2:
+            found = find_sse2(haystack.data(), haystack.size(), pos, needle_, rare1_index_, rare2_index_);
+            break;
+        default:
+            break;
+    }
+    if (found != npos) {
+        return found;
+    }
+#endif
+    
+    return find_scalar(haystack.data(), haystack.size(), pos);
+}
+
+size_t LiteralSearcher::find_scalar(const char* haystack, size_t size, size_t from) const {
+    const size_t n = needle_.size();
+    const char rare = needle_[rare1_index_];
+    
+    // memchr for the rarest byte, then verify the candidate
+    size_t pos = from + rare1_index_;
+    while (pos + (n - rare1_index_) <= size) {
+        const void* hit = std::memchr(haystack + pos, rare, size - pos - (n - rare1_index_) + 1);
+        if (!hit) {
+            break;
+        }
+        size_t candidate = static_cast<const char*>(hit) - haystack - rare1_index_;
+        if (std::memcmp(haystack + candidate, needle_.data(), n) == 0) {
+            return candidate;
+        }
+        pos = candidate + rare1_index_ + 1;
+    }
+    return npos;
+}
+
+std::vector<size_t> LiteralSearcher::find_all(std::string_view haystack) const {
+    std::vector<size_t> offsets;
+    const size_t step = needle_.empty() ? 1 : needle_.size();
+    
+    for (size_t pos = find(haystack, 0); pos != npos; pos = find(haystack, pos + step)) {
+        offsets.push_back(pos);
+    }
+    return offsets;
+}
+
+} // namespace cpp_ripgrep
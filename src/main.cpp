@@ -13,12 +13,19 @@ int main(int argc, char* argv[]) {
 
         // Create and run grep engine
         cpp_ripgrep::GrepEngine engine(options);
+        if (!engine.is_valid()) {
+            std::cerr << "Error: " << engine.get_error() << "\n";
+            return 1;
+        }
         int result = engine.search();
 
         // End performance timer
         auto end = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double> elapsed = end - start;
-        std::cout << "Search completed in " << elapsed.count() << " seconds.\n";
+        if (!options.json) {
+            // JSON output ends with its own summary event
+            std::cout << "Search completed in " << elapsed.count() << " seconds.\n";
+        }
 
         return result;
 
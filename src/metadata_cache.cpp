@@ -0,0 +1,173 @@
+#include "metadata_cache.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace cpp_ripgrep {
+
+namespace {
+
+constexpr char kMagic[8] = {'C', 'R', 'G', 'M', 'E', 'T', 'A', '\0'};
+constexpr uint32_t kVersion = 1;
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t count;
+};
+
+bool entry_less(const MetadataCache::Entry& a, const MetadataCache::Entry& b) {
+    return a.device != b.device ? a.device < b.device : a.inode < b.inode;
+}
+
+} // namespace
+
+std::unique_ptr<MetadataCache> MetadataCache::open(const std::string& path) {
+    std::unique_ptr<MetadataCache> cache(new MetadataCache(path));
+
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        if (errno != ENOENT) {
+            std::cerr << "Warning: Cannot read metadata cache " << path << ": " << std::strerror(errno) << "\n";
+        }
+        return cache;
+    }
+
+    struct stat st;
+    void* mapped = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        mapped = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Warning: Cannot read metadata cache " << path << "\n";
+        return cache;
+    }
+    cache->data_ = FileBuffer::from_mapping(mapped, static_cast<size_t>(st.st_size));
+
+    const size_t size = cache->data_.size();
+    const Header* header = reinterpret_cast<const Header*>(cache->data_.data());
+    if (size < sizeof(Header) || std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 ||
+        header->version != kVersion ||
+        header->count > (size - sizeof(Header)) / sizeof(Entry)) {
+        std::cerr << "Warning: Ignoring invalid metadata cache " << path << "\n";
+        cache->data_ = FileBuffer();
+        return cache;
+    }
+    cache->entries_ = reinterpret_cast<const Entry*>(cache->data_.data() + sizeof(Header));
+    cache->count_ = static_cast<size_t>(header->count);
+#endif
+
+    return cache;
+}
+
+MetadataCache::~MetadataCache() = default;
+
+const MetadataCache::Entry* MetadataCache::find(uint64_t device, uint64_t inode) const {
+    Entry key{};
+    key.device = device;
+    key.inode = inode;
+    const Entry* end = entries_ + count_;
+    const Entry* it = std::lower_bound(entries_, end, key, entry_less);
+    if (it != end && it->device == device && it->inode == inode) {
+        return it;
+    }
+    return nullptr;
+}
+
+MetadataCache::Kind MetadataCache::lookup(const FileIdentity& identity) const {
+    const Entry* entry = find(identity.device, identity.inode);
+    if (!entry || entry->mtime != identity.mtime || entry->size != identity.size) {
+        return Kind::UNKNOWN;
+    }
+    return static_cast<Kind>(entry->kind);
+}
+
+void MetadataCache::record(const FileIdentity& identity, Kind kind) {
+    if (lookup(identity) == kind) {
+        return;
+    }
+
+    Entry entry{};
+    entry.device = identity.device;
+    entry.inode = identity.inode;
+    entry.mtime = identity.mtime;
+    entry.size = identity.size;
+    entry.kind = static_cast<uint32_t>(kind);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    recorded_.push_back(entry);
+}
+
+bool MetadataCache::save(std::string& error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (recorded_.empty()) {
+        return true;
+    }
+
+    // New facts replace the mapped entries for the same file
+    std::stable_sort(recorded_.begin(), recorded_.end(), entry_less);
+    std::vector<Entry> merged;
+    merged.reserve(count_ + recorded_.size());
+    std::merge(recorded_.begin(), recorded_.end(), entries_, entries_ + count_,
+               std::back_inserter(merged), entry_less);
+    merged.erase(std::unique(merged.begin(), merged.end(), [](const Entry& a, const Entry& b) {
+        return a.device == b.device && a.inode == b.inode;
+    }), merged.end());
+
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.count = merged.size();
+
+    const std::string temp_path = path_ + ".tmp";
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            error = "cannot create " + temp_path;
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(merged.data()),
+                  static_cast<std::streamsize>(merged.size() * sizeof(Entry)));
+        out.flush();
+        if (!out) {
+            error = "cannot write " + temp_path;
+            std::remove(temp_path.c_str());
+            return false;
+        }
+    }
+
+    std::error_code rename_error;
+    std::filesystem::rename(temp_path, path_, rename_error);
+    if (rename_error) {
+        error = "cannot replace " + path_ + ": " + rename_error.message();
+        std::remove(temp_path.c_str());
+        return false;
+    }
+
+    // Later lookups and saves go by the table just written, so a reused
+    // engine does not record the same facts and rewrite the file again.
+    // Saving happens between searches, when no worker is looking up.
+    saved_ = std::move(merged);
+    entries_ = saved_.data();
+    count_ = saved_.size();
+    data_ = FileBuffer();
+    recorded_.clear();
+    return true;
+}
+
+} // namespace cpp_ripgrep
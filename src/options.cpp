@@ -1,21 +1,32 @@
 #include "options.hpp"
+#include <fstream>
 #include <iostream>
 #include <cstring>
 #include <algorithm>
 #include <thread>
+#include <cctype>
 
 namespace cpp_ripgrep {
 
 Options OptionsParser::parse(int argc, char* argv[]) {
     Options options;
+    bool explicit_patterns = false;
+    std::vector<std::string> positional;
     
     if (argc < 2) {
         print_usage(argv[0]);
         std::exit(1);
     }
     
+    // `index` subcommand: every positional argument is a path to index
+    int first_arg = 1;
+    if (std::strcmp(argv[1], "index") == 0) {
+        options.build_index = true;
+        first_arg = 2;
+    }
+    
     // Parse arguments
-    for (int i = 1; i < argc; ++i) {
+    for (int i = first_arg; i < argc; ++i) {
         std::string arg = argv[i];
         
         if (arg == "--help" || arg == "-h") {
@@ -28,13 +39,26 @@ Options OptionsParser::parse(int argc, char* argv[]) {
             options.recursive = true;
         } else if (arg == "--no-recursive") {
             options.recursive = false;
+        } else if (arg == "--no-ignore") {
+            options.no_ignore = true;
         } else if (arg == "--ignore-case" || arg == "-i") {
             options.ignore_case = true;
+        } else if (arg == "--fixed-strings" || arg == "-F") {
+            options.fixed_strings = true;
         } else if (arg == "--line-number" || arg == "-n") {
             options.line_number = true;
             options.show_line_number = true;
         } else if (arg == "--count" || arg == "-c") {
             options.count_only = true;
+        } else if (arg == "--files-with-matches" || arg == "-l") {
+            options.files_with_matches = true;
+        } else if (arg == "--max-count" || arg == "-m") {
+            if (i + 1 < argc) {
+                options.max_count = std::stoi(argv[++i]);
+            } else {
+                std::cerr << "Error: --max-count requires a value\n";
+                std::exit(1);
+            }
         } else if (arg == "--invert-match" || arg == "-v") {
             options.invert_match = true;
         } else if (arg == "--word-regexp" || arg == "-w") {
@@ -69,6 +93,55 @@ Options OptionsParser::parse(int argc, char* argv[]) {
                 std::cerr << "Error: --include requires a pattern\n";
                 std::exit(1);
             }
+        } else if (arg == "--regexp" || arg == "-e") {
+            if (i + 1 < argc) {
+                options.patterns.push_back(argv[++i]);
+                explicit_patterns = true;
+            } else {
+                std::cerr << "Error: --regexp requires a pattern\n";
+                std::exit(1);
+            }
+        } else if (arg == "--file" || arg == "-f") {
+            if (i + 1 < argc) {
+                read_pattern_file(argv[++i], options.patterns);
+                explicit_patterns = true;
+            } else {
+                std::cerr << "Error: --file requires a path\n";
+                std::exit(1);
+            }
+        } else if (arg == "--pattern-index") {
+            options.show_pattern_index = true;
+        } else if (arg == "--search-zip" || arg == "-z") {
+            options.search_zip = true;
+        } else if (arg == "--stop-at-nul") {
+            options.stop_at_nul = true;
+        } else if (arg == "--split-threshold") {
+            if (i + 1 < argc) {
+                options.split_threshold = parse_size(argv[++i]);
+            } else {
+                std::cerr << "Error: --split-threshold requires a size\n";
+                std::exit(1);
+            }
+        } else if (arg == "--stats") {
+            options.stats = true;
+        } else if (arg == "--json") {
+            options.json = true;
+        } else if (arg == "--cache") {
+            if (i + 1 < argc) {
+                options.cache_path = argv[++i];
+            } else {
+                std::cerr << "Error: --cache requires a file\n";
+                std::exit(1);
+            }
+        } else if (arg == "--index") {
+            if (i + 1 < argc) {
+                options.index_path = argv[++i];
+            } else {
+                std::cerr << "Error: --index requires a file\n";
+                std::exit(1);
+            }
+        } else if (arg == "--sort-files") {
+            options.sort_files = true;
         } else if (arg == "--quiet" || arg == "-q") {
             options.quiet = true;
         } else if (arg == "--no-filename" || arg == "-h") {
@@ -96,6 +169,23 @@ Options OptionsParser::parse(int argc, char* argv[]) {
                 std::cerr << "Error: --regex-engine requires a value\n";
                 std::exit(1);
             }
+        } else if (arg == "--io") {
+            if (i + 1 < argc) {
+                std::string backend = argv[++i];
+                if (backend == "mmap") {
+                    options.io_backend = IoBackend::MMAP;
+                } else if (backend == "pread") {
+                    options.io_backend = IoBackend::PREAD;
+                } else if (backend == "io_uring") {
+                    options.io_backend = IoBackend::IO_URING;
+                } else {
+                    std::cerr << "Error: Invalid I/O backend. Use 'mmap', 'pread' or 'io_uring'\n";
+                    std::exit(1);
+                }
+            } else {
+                std::cerr << "Error: --io requires a value\n";
+                std::exit(1);
+            }
         } else if (arg == "--no-color") {
             options.color = "never";
         } else if (arg[0] == '-') {
@@ -104,11 +194,28 @@ Options OptionsParser::parse(int argc, char* argv[]) {
             std::exit(1);
         } else {
             // This is either the pattern or a path
-            if (options.pattern.empty()) {
-                options.pattern = arg;
-            } else {
-                options.paths.push_back(arg);
+            positional.push_back(arg);
+        }
+    }
+    
+    // With -e/-f every positional argument is a path
+    for (const auto& arg : positional) {
+        if (!explicit_patterns && options.patterns.empty() && !options.build_index) {
+            options.patterns.push_back(arg);
+        } else {
+            options.paths.push_back(arg);
+        }
+    }
+    
+    // Regex engines see several patterns as one alternation
+    if (options.patterns.size() == 1) {
+        options.pattern = options.patterns.front();
+    } else {
+        for (const auto& pattern : options.patterns) {
+            if (!options.pattern.empty()) {
+                options.pattern += "|";
             }
+            options.pattern += "(?:" + pattern + ")";
         }
     }
     
@@ -117,16 +224,31 @@ Options OptionsParser::parse(int argc, char* argv[]) {
         options.paths.push_back(".");
     }
     
+    if (options.build_index && options.index_path.empty()) {
+        options.index_path = kDefaultIndexPath;
+    }
+    
     // Auto-detect thread count
     if (options.threads == 0) {
         options.threads = std::thread::hardware_concurrency();
         if (options.threads == 0) options.threads = 4; // fallback
     }
     
-    // Determine search mode
-    if (options.ignore_case) {
+    // Determine search mode; with -F every pattern is literal, so indicator
+    // lists full of dots still go to Aho-Corasick
+    bool has_regex_syntax = !options.fixed_strings &&
+        std::any_of(options.patterns.begin(), options.patterns.end(),
+            [](const std::string& pattern) {
+                return pattern.find_first_of(".*+?^$()[]{}|\\") != std::string::npos;
+            });
+    if (options.fixed_strings && (options.patterns.size() > 1 || options.ignore_case)) {
+        // LiteralSearcher has no caseless mode; the automaton does
+        options.mode = SearchMode::MULTI_LITERAL;
+    } else if (options.patterns.size() > 1 && !has_regex_syntax) {
+        options.mode = SearchMode::MULTI_LITERAL;
+    } else if (options.ignore_case) {
         options.mode = SearchMode::CASE_INSENSITIVE;
-    } else if (options.pattern.find_first_of(".*+?^$()[]{}|\\") != std::string::npos) {
+    } else if (has_regex_syntax) {
         options.mode = SearchMode::REGEX;
     } else {
         options.mode = SearchMode::LITERAL;
@@ -137,11 +259,18 @@ Options OptionsParser::parse(int argc, char* argv[]) {
 }
 
 void OptionsParser::validate_options(const Options& options) {
-    if (options.pattern.empty()) {
+    if (options.pattern.empty() && !options.build_index) {
         std::cerr << "Error: No search pattern provided\n";
         std::exit(1);
     }
     
+    if (options.mode == SearchMode::MULTI_LITERAL &&
+        std::any_of(options.patterns.begin(), options.patterns.end(),
+                    [](const std::string& pattern) { return pattern.empty(); })) {
+        std::cerr << "Error: Empty patterns are not supported with multiple patterns\n";
+        std::exit(1);
+    }
+    
     if (options.threads < 1) {
         std::cerr << "Error: Thread count must be at least 1\n";
         std::exit(1);
@@ -151,17 +280,56 @@ void OptionsParser::validate_options(const Options& options) {
         std::cerr << "Error: Max depth must be -1 or greater\n";
         std::exit(1);
     }
+    
+    if (options.max_count < -1) {
+        std::cerr << "Error: Max count must be 0 or greater\n";
+        std::exit(1);
+    }
+    
+    if (options.json && (options.count_only || options.files_with_matches)) {
+        std::cerr << "Error: --json cannot be combined with --count or --files-with-matches\n";
+        std::exit(1);
+    }
+}
+
+void OptionsParser::read_pattern_file(const std::string& path, std::vector<std::string>& patterns) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Error: Cannot read pattern file: " << path << "\n";
+        std::exit(1);
+    }
+    
+    // One pattern per line; blank lines are ignored
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!line.empty()) {
+            patterns.push_back(line);
+        }
+    }
 }
 
 void OptionsParser::print_usage(const char* program_name) {
     std::cout << "Usage: " << program_name << " [OPTIONS] PATTERN [PATH...]\n"
+              << "       " << program_name << " [OPTIONS] -e PATTERN... [-f FILE] [PATH...]\n"
+              << "       " << program_name << " index [--index FILE] [OPTIONS] [PATH...]\n"
               << "\n"
               << "Search for PATTERN in files at PATH (default: current directory)\n"
+              << "The index subcommand builds or refreshes a trigram index of PATH\n"
+              << "(default file: " << kDefaultIndexPath << "); only changed files are read again\n"
               << "\n"
               << "Options:\n"
+              << "  -e, --regexp PATTERN    Search for PATTERN (may be repeated)\n"
+              << "  -f, --file FILE         Read patterns from FILE, one per line\n"
+              << "  -F, --fixed-strings     Treat every pattern as a literal string\n"
+              << "  --pattern-index         Show which pattern matched each line\n"
               << "  -i, --ignore-case       Case insensitive search\n"
               << "  -n, --line-number       Show line numbers\n"
               << "  -c, --count             Only show count of matches\n"
+              << "  -l, --files-with-matches  Only show names of files with a match\n"
+              << "  -m, --max-count NUM     Stop searching a file after NUM matching lines\n"
               << "  -v, --invert-match      Invert match\n"
               << "  -w, --word-regexp       Match whole words only\n"
               << "  -x, --line-regexp       Match whole lines only\n"
@@ -169,12 +337,27 @@ void OptionsParser::print_usage(const char* program_name) {
               << "  --no-recursive          Don't search directories recursively\n"
               << "  --max-depth DEPTH       Maximum directory depth\n"
               << "  -j, --threads NUM       Number of threads (default: auto)\n"
-              << "  --exclude PATTERN       Exclude files matching pattern\n"
-              << "  --include PATTERN       Only search files matching pattern\n"
+              << "  --sort-files            Print results in sorted file order\n"
+              << "  --stop-at-nul           Stop searching a file at its first NUL byte\n"
+              << "  -z, --search-zip        Search inside gzip-compressed files\n"
+              << "  --split-threshold SIZE  Split files larger than SIZE across threads\n"
+              << "                          (K, M or G suffix; 0 disables; default: 64M)\n"
+              << "  --stats                 Print search statistics\n"
+              << "  --json                  Print results as JSON Lines: begin, match and end\n"
+              << "                          events per file, then a summary\n"
+              << "  --exclude GLOB          Exclude files and directories matching glob;\n"
+              << "                          a trailing '/' matches directories only\n"
+              << "  --include GLOB          Only search files matching glob\n"
+              << "  --no-ignore             Don't respect .gitignore and .ignore files\n"
               << "  -q, --quiet             Suppress normal output\n"
               << "  --color WHEN            When to use colors (never, auto, always)\n"
               << "  --no-color              Disable colors\n"
               << "  --regex-engine ENGINE   Use specific regex engine (pcre2, re2)\n"
+              << "  --io BACKEND            How files are read (mmap, pread, io_uring)\n"
+              << "  --index FILE            Search only files the trigram index allows;\n"
+              << "                          files changed since indexing are searched anyway\n"
+              << "  --cache FILE            Remember which files are binary in FILE, so\n"
+              << "                          later runs skip them without reading them\n"
               << "  -h, --help              Show this help message\n"
               << "  -V, --version           Show version information\n"
               << "\n"
@@ -182,7 +365,10 @@ void OptionsParser::print_usage(const char* program_name) {
               << "  " << program_name << " hello                    # Search for 'hello' in current directory\n"
               << "  " << program_name << " -i hello src/            # Case insensitive search in src/\n"
               << "  " << program_name << " -r \"\\b\\w+\\b\" .         # Find all words using regex\n"
-              << "  " << program_name << " -c error *.log           # Count error lines in log files\n";
+              << "  " << program_name << " -c error *.log           # Count error lines in log files\n"
+              << "  " << program_name << " -f iocs.txt /var/log     # Search for every pattern in iocs.txt\n"
+              << "  " << program_name << " index src/               # Index src/ into " << kDefaultIndexPath << "\n"
+              << "  " << program_name << " --index " << kDefaultIndexPath << " foo src/\n";
 }
 
 void OptionsParser::print_version() {
@@ -190,4 +376,26 @@ void OptionsParser::print_version() {
               << "A fast grep-like tool written in C++\n";
 }
 
-} // namespace cpp_ripgrep 
\ No newline at end of file
+size_t OptionsParser::parse_size(const std::string& value) {
+    size_t digits = 0;
+    while (digits < value.size() && std::isdigit(static_cast<unsigned char>(value[digits]))) {
+        ++digits;
+    }
+    
+    size_t multiplier = 1;
+    const std::string suffix = value.substr(digits);
+    if (suffix == "K" || suffix == "k") {
+        multiplier = 1024;
+    } else if (suffix == "M" || suffix == "m") {
+        multiplier = 1024 * 1024;
+    } else if (suffix == "G" || suffix == "g") {
+        multiplier = 1024 * 1024 * 1024;
+    } else if (!suffix.empty() || digits == 0) {
+        std::cerr << "Error: Invalid size: " << value << "\n";
+        std::exit(1);
+    }
+    
+    return std::stoull(value.substr(0, digits)) * multiplier;
+}
+
+} // namespace cpp_ripgrep
@@ -0,0 +1,71 @@
+#include "output_sink.hpp"
+#include <cerrno>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace cpp_ripgrep {
+
+OutputSink::OutputSink(int fd) : fd_(fd) {
+#ifdef _WIN32
+    terminal_ = _isatty(fd) != 0;
+#else
+    terminal_ = isatty(fd) != 0;
+#endif
+    if (!terminal_) {
+        buffer_.reserve(kBufferSize);
+    }
+}
+
+OutputSink::~OutputSink() {
+    flush();
+}
+
+void OutputSink::write(std::string_view bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (terminal_) {
+        write_fd(bytes.data(), bytes.size());
+        return;
+    }
+
+    if (buffer_.size() + bytes.size() > kBufferSize) {
+        write_fd(buffer_.data(), buffer_.size());
+        buffer_.clear();
+    }
+    if (bytes.size() >= kBufferSize) {
+        // Too big to be worth copying
+        write_fd(bytes.data(), bytes.size());
+    } else {
+        buffer_.append(bytes.data(), bytes.size());
+    }
+}
+
+void OutputSink::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    write_fd(buffer_.data(), buffer_.size());
+    buffer_.clear();
+}
+
+void OutputSink::write_fd(const char* data, size_t size) {
+    while (size > 0 && !failed_) {
+#ifdef _WIN32
+        int n = _write(fd_, data, static_cast<unsigned int>(size > 0x40000000 ? 0x40000000 : size));
+#else
+        ssize_t n = ::write(fd_, data, size);
+#endif
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            failed_ = true;
+            break;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+}
+
+} // namespace cpp_ripgrep
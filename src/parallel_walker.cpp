@@ -0,0 +1,206 @@
+#include "parallel_walker.hpp"
+#include "options.hpp"
+#include <thread>
+
+namespace cpp_ripgrep {
+
+ParallelWalker::ParallelWalker(const FileScanner& scanner, const Options& options, size_t num_workers,
+                               const CancellationToken& cancel)
+    : scanner_(scanner), options_(options), cancel_(cancel), files_(kFileQueueCapacity) {
+    queues_.reserve(num_workers);
+    for (size_t i = 0; i < num_workers; ++i) {
+        queues_.push_back(std::make_unique<WorkerQueue>());
+    }
+}
+
+void ParallelWalker::seed(const std::vector<std::string>& paths) {
+    // Spread the roots so several workers have something to start on
+    size_t next = 0;
+    scanner_.scan_roots(paths, [&](const std::string& directory) {
+        WalkItem item;
+        item.path = directory;
+        item.is_directory = true;
+        push(next++ % queues_.size(), std::move(item));
+    }, [&](const FileInfo& file) {
+        WalkItem item;
+        item.path = file.path;
+        push(next++ % queues_.size(), std::move(item));
+    });
+}
+
+void ParallelWalker::work(size_t worker, const std::function<void(std::string_view)>& file_callback,
+                          const std::function<bool()>& idle_callback) {
+    unsigned idle_rounds = 0;
+    
+    while (true) {
+        if (cancel_.is_cancelled()) {
+            // Queued items are abandoned, so pending_ never drains; wake
+            // parked workers so they see the cancellation too
+            wake_all();
+            return;
+        }
+        
+        // Drain found files first so the ring rarely fills up
+        FileItem file;
+        if (files_.try_pop(file)) {
+            idle_rounds = 0;
+            file_callback(std::string_view(file.path, file.length));
+            finish_item();
+            continue;
+        }
+        
+        WalkItem item;
+        if (pop(worker, item) || steal(worker, item)) {
+            idle_rounds = 0;
+            if (item.task) {
+                item.task();
+            } else if (item.is_directory) {
+                expand_directory(worker, item, file_callback);
+            } else {
+                file_callback(item.path);
+            }
+            // Children were queued before this, so the count only reaches
+            // zero once no item is left anywhere
+            finish_item();
+            continue;
+        }
+        
+        if (idle_callback && idle_callback()) {
+            idle_rounds = 0;
+            continue;
+        }
+        
+        if (pending_.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+        
+        // Another worker is still expanding a directory: spin briefly, then park
+        if (++idle_rounds < kSpinRounds) {
+            std::this_thread::yield();
+        } else {
+            park();
+            idle_rounds = 0;
+        }
+    }
+}
+
+void ParallelWalker::spawn(std::function<void()> task) {
+    WalkItem item;
+    item.task = std::move(task);
+    push(next_spawn_.fetch_add(1, std::memory_order_relaxed) % queues_.size(), std::move(item));
+}
+
+void ParallelWalker::push(size_t worker, WalkItem item) {
+    pending_.fetch_add(1, std::memory_order_acq_rel);
+    {
+        WorkerQueue& queue = *queues_[worker];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.items.push_back(std::move(item));
+    }
+    wake_one();
+}
+
+bool ParallelWalker::pop(size_t worker, WalkItem& item) {
+    WorkerQueue& queue = *queues_[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.items.empty()) {
+        return false;
+    }
+    item = std::move(queue.items.back());
+    queue.items.pop_back();
+    return true;
+}
+
+bool ParallelWalker::steal(size_t thief, WalkItem& item) {
+    for (size_t offset = 1; offset < queues_.size(); ++offset) {
+        WorkerQueue& victim = *queues_[(thief + offset) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.items.empty()) {
+            item = std::move(victim.items.front());
+            victim.items.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ParallelWalker::expand_directory(size_t worker, const WalkItem& directory,
+                                      const std::function<void(std::string_view)>& file_callback) {
+    if (options_.max_depth >= 0 && directory.depth > options_.max_depth) {
+        return;
+    }
+    if (cancel_.is_cancelled()) {
+        return;
+    }
+    
+    WorkerQueue& own = *queues_[worker];
+    scanner_.read_directory(directory.path, directory.ignore,
+                            [&](const std::string& subdirectory, const IgnoreRules::Ptr& ignore) {
+        WalkItem item;
+        item.path = subdirectory;
+        item.is_directory = true;
+        item.depth = directory.depth + 1;
+        item.ignore = ignore;
+        push(worker, std::move(item));
+    }, [&](const FileInfo& file) {
+        FileItem item;
+        item.path = own.arena.store(file.path);
+        item.length = static_cast<uint32_t>(file.path.size());
+        
+        pending_.fetch_add(1, std::memory_order_acq_rel);
+        if (files_.try_push(item)) {
+            wake_one();
+        } else {
+            // Ring is full: every worker is busy, so search the file here
+            // rather than block a producer
+            file_callback(std::string_view(item.path, item.length));
+            finish_item();
+        }
+    });
+}
+
+void ParallelWalker::finish_item() {
+    if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        wake_all();
+    }
+}
+
+bool ParallelWalker::has_work() {
+    if (!files_.empty()) {
+        return true;
+    }
+    for (auto& queue : queues_) {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        if (!queue->items.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ParallelWalker::park() {
+    std::unique_lock<std::mutex> lock(park_mutex_);
+    parked_.fetch_add(1, std::memory_order_seq_cst);
+    // Pairs with the fence in wake_one: either the producer sees this
+    // worker parked, or this check sees the producer's item
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    park_cv_.wait(lock, [this] {
+        return pending_.load(std::memory_order_acquire) == 0 || cancel_.is_cancelled() || has_work();
+    });
+    parked_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void ParallelWalker::wake_one() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (parked_.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(park_mutex_);
+        park_cv_.notify_one();
+    }
+}
+
+void ParallelWalker::wake_all() {
+    std::lock_guard<std::mutex> lock(park_mutex_);
+    park_cv_.notify_all();
+}
+
+} // namespace cpp_ripgrep
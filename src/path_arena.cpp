@@ -0,0 +1,33 @@
+#include "path_arena.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace cpp_ripgrep {
+
+const char* PathArena::store(std::string_view path) {
+    const size_t needed = path.size() + 1;
+    if (needed > remaining_) {
+        // Oversized paths get a block of their own
+        const size_t block_size = std::max(kBlockSize, needed);
+        blocks_.push_back(std::make_unique<char[]>(block_size));
+        cursor_ = blocks_.back().get();
+        remaining_ = block_size;
+    }
+
+    char* copy = cursor_;
+    std::memcpy(copy, path.data(), path.size());
+    copy[path.size()] = '\0';
+    cursor_ += needed;
+    remaining_ -= needed;
+    used_ += needed;
+    return copy;
+}
+
+void PathArena::clear() {
+    blocks_.clear();
+    cursor_ = nullptr;
+    remaining_ = 0;
+    used_ = 0;
+}
+
+} // namespace cpp_ripgrep
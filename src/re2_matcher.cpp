@@ -11,11 +11,16 @@ RE2Matcher::RE2Matcher(const std::string& pattern, bool case_insensitive)
     re2::RE2::Options options;
     options.set_case_sensitive(!case_insensitive);
     
-    regex_ = std::make_unique<re2::RE2>(pattern, options);
+    // Multi-line mode so ^ and $ anchor at line boundaries when a whole file
+    // buffer is searched at once, matching PCRE2_MULTILINE
+    regex_ = std::make_unique<re2::RE2>("(?m)" + pattern, options);
     
     if (!regex_->ok()) {
         error_ = regex_->error();
+        return;
     }
+    
+    prefilter_ = RegexPrefilter::build(pattern, case_insensitive);
 #else
     error_ = "RE2 support not compiled in";
 #endif
@@ -48,6 +53,7 @@ void RE2Matcher::move_from(RE2Matcher&& other) {
 #ifdef HAVE_RE2
     regex_ = std::move(other.regex_);
 #endif
+    prefilter_ = std::move(other.prefilter_);
     error_ = std::move(other.error_);
     pattern_ = std::move(other.pattern_);
     case_insensitive_ = other.case_insensitive_;
@@ -61,7 +67,7 @@ bool RE2Matcher::is_valid() const {
 #endif
 }
 
-std::vector<Match> RE2Matcher::find_all(const std::string& text) const {
+std::vector<Match> RE2Matcher::find_all(std::string_view text) const {
     std::vector<Match> matches;
     
 #ifdef HAVE_RE2
@@ -69,57 +75,88 @@ std::vector<Match> RE2Matcher::find_all(const std::string& text) const {
         return matches;
     }
     
-    re2::StringPiece input(text);
+    const re2::StringPiece input(text.data(), text.size());
     re2::StringPiece match_text;
     size_t start_pos = 0;
     
-    while (re2::RE2::FindAndConsume(&input, *regex_, &match_text)) {
+    // An empty match is allowed at the very end, so "^$" matches an empty line
+    while (start_pos <= text.size() &&
+           regex_->Match(input, start_pos, text.size(), re2::RE2::UNANCHORED, &match_text, 1)) {
         Match match;
-        match.start = start_pos + (text.data() + start_pos - input.data());
+        match.start = match_text.data() - text.data();
         match.end = match.start + match_text.size();
-        match.text = std::string(match_text);
+        match.text = std::string(match_text.data(), match_text.size());
         matches.push_back(match);
         
-        start_pos = match.end;
-        if (start_pos >= text.length()) {
-            break;
-        }
+        start_pos = match.end == match.start ? match.end + 1 : match.end;
     }
 #endif
     
     return matches;
 }
 
-bool RE2Matcher::matches(const std::string& text) const {
+bool RE2Matcher::matches(std::string_view text) const {
 #ifdef HAVE_RE2
     if (!is_valid()) {
         return false;
     }
     
-    return re2::RE2::FullMatch(text, *regex_);
+    return re2::RE2::FullMatch(re2::StringPiece(text.data(), text.size()), *regex_);
 #else
     return false;
 #endif
 }
 
-std::optional<Match> RE2Matcher::find_first(const std::string& text) const {
+std::optional<Match> RE2Matcher::find_first(std::string_view text) const {
 #ifdef HAVE_RE2
-    if (!is_valid()) {
+    auto range = search_from(text, 0);
+    if (range) {
+        Match match;
+        match.start = range->start;
+        match.end = range->end;
+        match.text = std::string(text.substr(range->start, range->end - range->start));
+        return match;
+    }
+#endif
+    
+    return std::nullopt;
+}
+
+std::optional<MatchRange> RE2Matcher::find_next(std::string_view text, size_t start_offset) const {
+    if (!prefilter_) {
+        return search_from(text, start_offset);
+    }
+    
+    // Only run the regex on lines holding the required literal
+    size_t line_start, line_end;
+    for (size_t pos = start_offset; prefilter_->next_candidate_line(text, pos, line_start, line_end);
+         pos = line_end + 1) {
+        // The line is the whole subject, as when the engine checks a line
+        const size_t from = std::max(line_start, start_offset);
+        auto range = search_from(text.substr(line_start, line_end - line_start), from - line_start);
+        if (range) {
+            return MatchRange{range->start + line_start, range->end + line_start};
+        }
+    }
+    
+    return std::nullopt;
+}
+
+std::optional<MatchRange> RE2Matcher::search_from(std::string_view text, size_t start_offset) const {
+#ifdef HAVE_RE2
+    if (!is_valid() || start_offset > text.size()) {
         return std::nullopt;
     }
     
-    re2::StringPiece input(text);
     re2::StringPiece match_text;
-    if (re2::RE2::FindAndConsume(&input, *regex_, &match_text)) {
-        Match match;
-        match.start = match_text.data() - text.data();
-        match.end = match.start + match_text.size();
-        match.text = std::string(match_text);
-        return match;
+    if (regex_->Match(re2::StringPiece(text.data(), text.size()), start_offset, text.size(),
+                      re2::RE2::UNANCHORED, &match_text, 1)) {
+        size_t start = match_text.data() - text.data();
+        return MatchRange{start, start + match_text.size()};
     }
 #endif
     
     return std::nullopt;
 }
 
-} // namespace cpp_ripgrep 
\ No newline at end of file
+} // namespace cpp_ripgrep
\ No newline at end of file
@@ -0,0 +1,197 @@
+#include "re2_set_matcher.hpp"
+#include <algorithm>
+
+namespace cpp_ripgrep {
+
+RE2SetMatcher::RE2SetMatcher(const std::vector<std::string>& patterns, bool case_insensitive) {
+#ifdef HAVE_RE2
+    re2::RE2::Options options;
+    options.set_case_sensitive(!case_insensitive);
+    options.set_log_errors(false);
+    // The set DFA for hundreds of rules outgrows RE2's 8MB default
+    options.set_max_mem(static_cast<int64_t>(256) << 20);
+
+    set_ = std::make_unique<re2::RE2::Set>(options, re2::RE2::UNANCHORED);
+
+    for (size_t i = 0; i < patterns.size(); ++i) {
+        // Multi-line mode so ^ and $ anchor at line boundaries, as in RE2Matcher
+        const std::string pattern = "(?m)" + patterns[i];
+
+        std::string error;
+        if (set_->Add(pattern, &error) < 0) {
+            error_ = "rule " + std::to_string(i) + ": " + error;
+            return;
+        }
+        rules_.push_back(std::make_unique<re2::RE2>(pattern, options));
+        if (!rules_.back()->ok()) {
+            error_ = "rule " + std::to_string(i) + ": " + rules_.back()->error();
+            return;
+        }
+    }
+
+    if (!set_->Compile()) {
+        error_ = "Failed to compile RE2 rule set";
+    }
+#else
+    (void)patterns;
+    (void)case_insensitive;
+    error_ = "RE2 support not compiled in";
+#endif
+}
+
+RE2SetMatcher::~RE2SetMatcher() = default;
+
+size_t RE2SetMatcher::rule_count() const {
+#ifdef HAVE_RE2
+    return rules_.size();
+#else
+    return 0;
+#endif
+}
+
+std::vector<int> RE2SetMatcher::matching_rules(std::string_view text) const {
+    std::vector<int> rules;
+
+#ifdef HAVE_RE2
+    if (!is_valid()) {
+        return rules;
+    }
+
+    re2::RE2::Set::ErrorInfo error_info;
+    if (!set_->Match(re2::StringPiece(text.data(), text.size()), &rules, &error_info) &&
+        error_info.kind != re2::RE2::Set::kNoError) {
+        // The DFA ran out of memory; fall back to trying every rule
+        rules.resize(rules_.size());
+        for (size_t i = 0; i < rules.size(); ++i) {
+            rules[i] = static_cast<int>(i);
+        }
+    }
+    std::sort(rules.begin(), rules.end());
+#endif
+
+    return rules;
+}
+
+std::optional<MatchRange> RE2SetMatcher::find_rule(int rule, std::string_view text, size_t start_offset) const {
+#ifdef HAVE_RE2
+    if (start_offset > text.size()) {
+        return std::nullopt;
+    }
+
+    re2::StringPiece match_text;
+    if (rules_[rule]->Match(re2::StringPiece(text.data(), text.size()), start_offset, text.size(),
+                            re2::RE2::UNANCHORED, &match_text, 1)) {
+        size_t start = match_text.data() - text.data();
+        return MatchRange{start, start + match_text.size()};
+    }
+#else
+    (void)rule;
+    (void)text;
+    (void)start_offset;
+#endif
+
+    return std::nullopt;
+}
+
+std::vector<Match> RE2SetMatcher::find_all(std::string_view text) const {
+    std::vector<Match> candidates;
+
+    for (int rule : matching_rules(text)) {
+        // An empty match is allowed at the very end, so "^$" matches an empty line
+        for (size_t pos = 0; pos <= text.size();) {
+            auto range = find_rule(rule, text, pos);
+            if (!range) {
+                break;
+            }
+            Match match;
+            match.start = range->start;
+            match.end = range->end;
+            match.pattern_index = static_cast<size_t>(rule);
+            candidates.push_back(match);
+
+            pos = range->end == range->start ? range->end + 1 : range->end;
+        }
+    }
+
+    // Keep the leftmost-longest non-overlapping matches across all rules
+    std::sort(candidates.begin(), candidates.end(), [](const Match& a, const Match& b) {
+        if (a.start != b.start) {
+            return a.start < b.start;
+        }
+        if (a.end != b.end) {
+            return a.end > b.end;
+        }
+        return a.pattern_index < b.pattern_index;
+    });
+
+    std::vector<Match> matches;
+    for (auto& match : candidates) {
+        if (!matches.empty() && match.start < matches.back().end) {
+            continue;
+        }
+        if (!matches.empty() && match.start == match.end && match.start == matches.back().start) {
+            continue;
+        }
+        match.text = std::string(text.substr(match.start, match.end - match.start));
+        matches.push_back(std::move(match));
+    }
+
+    return matches;
+}
+
+bool RE2SetMatcher::matches(std::string_view text) const {
+#ifdef HAVE_RE2
+    for (int rule : matching_rules(text)) {
+        if (re2::RE2::FullMatch(re2::StringPiece(text.data(), text.size()), *rules_[rule])) {
+            return true;
+        }
+    }
+#endif
+    return false;
+}
+
+std::optional<Match> RE2SetMatcher::find_first(std::string_view text) const {
+    auto matches = find_all(text);
+    if (matches.empty()) {
+        return std::nullopt;
+    }
+    return matches.front();
+}
+
+RE2SetMatcher::Cursor RE2SetMatcher::scan(std::string_view text) const {
+    return Cursor(*this, text, matching_rules(text));
+}
+
+RE2SetMatcher::Cursor::Cursor(const RE2SetMatcher& matcher, std::string_view text, std::vector<int> rules)
+    : matcher_(&matcher), text_(text) {
+    pending_.reserve(rules.size());
+    for (int rule : rules) {
+        pending_.push_back(Pending{rule, false, MatchRange{0, 0}});
+    }
+}
+
+std::optional<MatchRange> RE2SetMatcher::Cursor::next(size_t from) {
+    std::optional<MatchRange> best;
+
+    for (auto it = pending_.begin(); it != pending_.end();) {
+        // Rules whose next match is still ahead of `from` need no new search
+        if (!it->searched || it->range.start < from) {
+            auto range = matcher_->find_rule(it->rule, text_, from);
+            if (!range) {
+                it = pending_.erase(it);
+                continue;
+            }
+            it->range = *range;
+            it->searched = true;
+        }
+        if (!best || it->range.start < best->start ||
+            (it->range.start == best->start && it->range.end > best->end)) {
+            best = it->range;
+        }
+        ++it;
+    }
+
+    return best;
+}
+
+} // namespace cpp_ripgrep
@@ -1,13 +1,61 @@
 #include "regex_matcher.hpp"
 #include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <iostream>
 
 namespace cpp_ripgrep {
 
+struct RegexMatcher::MatchScratch {
+    uint64_t owner = 0;
+#ifdef HAVE_PCRE2
+    pcre2_match_data* match_data = nullptr;
+    pcre2_match_context* match_context = nullptr;
+    pcre2_jit_stack* jit_stack = nullptr;
+#endif
+
+    ~MatchScratch() {
+        reset();
+    }
+
+    void reset() {
+#ifdef HAVE_PCRE2
+        if (match_data) {
+            pcre2_match_data_free(match_data);
+            match_data = nullptr;
+        }
+        if (match_context) {
+            pcre2_match_context_free(match_context);
+            match_context = nullptr;
+        }
+        if (jit_stack) {
+            pcre2_jit_stack_free(jit_stack);
+            jit_stack = nullptr;
+        }
+#endif
+        owner = 0;
+    }
+};
+
+namespace {
+
+// Matcher ids tie per-thread scratch space to a matcher. They are never
+// reused, so scratch left behind by a destroyed matcher is simply evicted.
+std::atomic<uint64_t> next_matcher_id{1};
+
+// A worker thread rarely uses more than one or two matchers at a time,
+// but a large pattern set is split across several (see RegexSetMatcher)
+constexpr size_t kScratchSlots = 16;
+
+// JIT stack grows on demand up to the maximum
+constexpr size_t kJitStackStart = 32 * 1024;
+constexpr size_t kJitStackMax = 1024 * 1024;
+
+} // namespace
+
 RegexMatcher::RegexMatcher(const std::string& pattern, bool case_insensitive)
 #ifdef HAVE_PCRE2
-    : code_(nullptr), match_data_(nullptr) {
+    : code_(nullptr), id_(next_matcher_id.fetch_add(1)) {
     
     int options = PCRE2_MULTILINE;
     if (case_insensitive) {
@@ -17,14 +65,23 @@ RegexMatcher::RegexMatcher(const std::string& pattern, bool case_insensitive)
     int error_code;
     PCRE2_SIZE error_offset;
     
+    // Only '\n' ends a line, as for RE2: a lone '\r' stays an ordinary
+    // byte that '.' matches and '^'/'$' do not anchor around. The engine
+    // strips the '\r' of a CRLF ending before checking each line.
+    pcre2_compile_context* compile_context = pcre2_compile_context_create(nullptr);
+    if (compile_context) {
+        pcre2_set_newline(compile_context, PCRE2_NEWLINE_LF);
+    }
+    
     code_ = pcre2_compile(
         reinterpret_cast<PCRE2_SPTR>(pattern.c_str()),
         PCRE2_ZERO_TERMINATED,
         options,
         &error_code,
         &error_offset,
-        nullptr
+        compile_context
     );
+    pcre2_compile_context_free(compile_context);
     
     if (code_ == nullptr) {
         PCRE2_UCHAR error_buffer[256];
@@ -33,11 +90,11 @@ RegexMatcher::RegexMatcher(const std::string& pattern, bool case_insensitive)
         return;
     }
     
-    match_data_ = pcre2_match_data_create_from_pattern(code_, nullptr);
-    if (match_data_ == nullptr) {
-        error_ = "Failed to create match data";
-        cleanup();
-    }
+    // JIT is optional: without it (or if the library was built without JIT
+    // support) matching falls back to the interpreter
+    jit_compiled_ = pcre2_jit_compile(code_, PCRE2_JIT_COMPLETE) == 0;
+    
+    prefilter_ = RegexPrefilter::build(pattern, case_insensitive);
 #else
     {
     error_ = "PCRE2 support not compiled in";
@@ -50,7 +107,7 @@ RegexMatcher::~RegexMatcher() {
 
 RegexMatcher::RegexMatcher(RegexMatcher&& other) noexcept
 #ifdef HAVE_PCRE2
-    : code_(nullptr), match_data_(nullptr), error_() {
+    : code_(nullptr), error_() {
 #else
     : error_() {
 #endif
@@ -67,10 +124,6 @@ RegexMatcher& RegexMatcher::operator=(RegexMatcher&& other) noexcept {
 
 void RegexMatcher::cleanup() {
 #ifdef HAVE_PCRE2
-    if (match_data_) {
-        pcre2_match_data_free(match_data_);
-        match_data_ = nullptr;
-    }
     if (code_) {
         pcre2_code_free(code_);
         code_ = nullptr;
@@ -81,37 +134,86 @@ void RegexMatcher::cleanup() {
 void RegexMatcher::move_from(RegexMatcher&& other) {
 #ifdef HAVE_PCRE2
     code_ = other.code_;
-    match_data_ = other.match_data_;
     other.code_ = nullptr;
-    other.match_data_ = nullptr;
 #endif
+    // Scratch is keyed by id, so it stays valid for the moved-to matcher
+    id_ = other.id_;
+    jit_compiled_ = other.jit_compiled_;
+    other.id_ = 0;
+    other.jit_compiled_ = false;
+    prefilter_ = std::move(other.prefilter_);
     error_ = std::move(other.error_);
 }
 
-std::vector<Match> RegexMatcher::find_all(const std::string& text) const {
+RegexMatcher::MatchScratch* RegexMatcher::scratch() const {
+    thread_local MatchScratch slots[kScratchSlots];
+    thread_local size_t next_victim = 0;
+    
+    for (auto& slot : slots) {
+        if (slot.owner == id_) {
+            return &slot;
+        }
+    }
+    
+    MatchScratch& slot = slots[next_victim];
+    next_victim = (next_victim + 1) % kScratchSlots;
+    slot.reset();
+    
+#ifdef HAVE_PCRE2
+    slot.match_data = pcre2_match_data_create_from_pattern(code_, nullptr);
+    slot.match_context = pcre2_match_context_create(nullptr);
+    if (!slot.match_data || !slot.match_context) {
+        slot.reset();
+        return nullptr;
+    }
+    if (jit_compiled_) {
+        // Without a private stack the JIT uses 32K of the machine stack
+        slot.jit_stack = pcre2_jit_stack_create(kJitStackStart, kJitStackMax, nullptr);
+        if (slot.jit_stack) {
+            pcre2_jit_stack_assign(slot.match_context, nullptr, slot.jit_stack);
+        }
+    }
+#endif
+    slot.owner = id_;
+    return &slot;
+}
+
+int RegexMatcher::run_match(std::string_view text, size_t start_offset, uint32_t options,
+                            MatchScratch* scratch) const {
+#ifdef HAVE_PCRE2
+    const PCRE2_SPTR subject = reinterpret_cast<PCRE2_SPTR>(text.data());
+    
+    // Anchoring options are not supported by the JIT fast path
+    if (jit_compiled_ && (options & (PCRE2_ANCHORED | PCRE2_ENDANCHORED)) == 0) {
+        int rc = pcre2_jit_match(code_, subject, text.length(), start_offset, options,
+                                 scratch->match_data, scratch->match_context);
+        if (rc != PCRE2_ERROR_JIT_STACKLIMIT) {
+            return rc;
+        }
+        // Pathological backtracking: retry in the interpreter
+        options |= PCRE2_NO_JIT;
+    }
+    
+    return pcre2_match(code_, subject, text.length(), start_offset, options,
+                       scratch->match_data, scratch->match_context);
+#else
+    return -1;
+#endif
+}
+
+std::vector<Match> RegexMatcher::find_all(std::string_view text) const {
     std::vector<Match> matches;
     
     #ifdef HAVE_PCRE2
-    if (!is_valid()) {
+    MatchScratch* scratch_space = is_valid() ? scratch() : nullptr;
+    if (!scratch_space) {
         return matches;
     }
     PCRE2_SIZE start_offset = 0;
-    const PCRE2_SPTR subject = reinterpret_cast<const PCRE2_SPTR>(text.c_str());
     const PCRE2_SIZE subject_length = text.length();
-    pcre2_match_data* match_data = pcre2_match_data_create_from_pattern(code_, nullptr);
-    if (!match_data) {
-        return matches;
-    }
-    while (start_offset < subject_length) {
-        int rc = pcre2_match(
-            code_,
-            subject,
-            subject_length,
-            start_offset,
-            0,
-            match_data,
-            nullptr
-        );
+    // An empty match is allowed at the very end, so "^$" matches an empty line
+    while (start_offset <= subject_length) {
+        int rc = run_match(text, start_offset, 0, scratch_space);
         if (rc < 0) {
             if (rc == PCRE2_ERROR_NOMATCH) {
                 break;
@@ -119,12 +221,13 @@ std::vector<Match> RegexMatcher::find_all(const std::string& text) const {
             // Handle other errors
             break;
         }
-        PCRE2_SIZE* ovector = pcre2_get_ovector_pointer(match_data);
+        PCRE2_SIZE* ovector = pcre2_get_ovector_pointer(scratch_space->match_data);
         Match match;
         match.start = ovector[0];
         match.end = ovector[1];
+        match.pattern_index = marked_pattern(scratch_space);
         if (match.start <= match.end && match.end <= text.size()) {
-            match.text = text.substr(match.start, match.end - match.start);
+            match.text = std::string(text.substr(match.start, match.end - match.start));
             matches.push_back(match);
         }
         // Move to next position
@@ -134,27 +237,52 @@ std::vector<Match> RegexMatcher::find_all(const std::string& text) const {
             start_offset = ovector[1];
         }
     }
-    pcre2_match_data_free(match_data);
     #endif
     
     return matches;
 }
 
-bool RegexMatcher::matches(const std::string& text) const {
+size_t RegexMatcher::marked_pattern(const MatchScratch* scratch) {
+    size_t index = 0;
 #ifdef HAVE_PCRE2
-    if (!is_valid()) {
+    PCRE2_SPTR mark = pcre2_get_mark(scratch->match_data);
+    if (mark == nullptr) {
+        return 0;
+    }
+    for (; *mark != 0; ++mark) {
+        if (*mark < '0' || *mark > '9') {
+            return 0;   // a mark of the user's own
+        }
+        index = index * 10 + (*mark - '0');
+    }
+#else
+    (void)scratch;
+#endif
+    return index;
+}
+
+std::string RegexMatcher::tagged_alternation(const std::vector<std::string>& patterns,
+                                             size_t begin, size_t end) {
+    end = std::min(end, patterns.size());
+    std::string joined;
+    for (size_t i = begin; i < end; ++i) {
+        if (i > begin) {
+            joined += '|';
+        }
+        joined += "(*MARK:" + std::to_string(i) + ")(?:" + patterns[i] + ")";
+    }
+    return joined;
+}
+
+bool RegexMatcher::matches(std::string_view text) const {
+#ifdef HAVE_PCRE2
+    MatchScratch* scratch_space = is_valid() ? scratch() : nullptr;
+    if (!scratch_space) {
         return false;
     }
     
-    int rc = pcre2_match(
-        code_,
-        reinterpret_cast<const PCRE2_SPTR>(text.c_str()),
-        text.length(),
-        0,
-        0,
-        match_data_,
-        nullptr
-    );
+    // The whole string has to match, as for RE2::FullMatch
+    int rc = run_match(text, 0, PCRE2_ANCHORED | PCRE2_ENDANCHORED, scratch_space);
     
     return rc >= 0;
 #else
@@ -162,40 +290,69 @@ bool RegexMatcher::matches(const std::string& text) const {
 #endif
 }
 
-std::optional<Match> RegexMatcher::find_first(const std::string& text) const {
+std::optional<Match> RegexMatcher::find_first(std::string_view text) const {
 #ifdef HAVE_PCRE2
-    if (!is_valid()) {
+    auto range = search_from(text, 0);
+    if (!range) {
         return std::nullopt;
     }
     
-    int rc = pcre2_match(
-        code_,
-        reinterpret_cast<const PCRE2_SPTR>(text.c_str()),
-        text.length(),
-        0,
-        0,
-        match_data_,
-        nullptr
-    );
+    Match match;
+    match.start = range->start;
+    match.end = range->end;
+    match.text = std::string(text.substr(match.start, match.end - match.start));
     
-    if (rc < 0) {
+    return match;
+#else
+    return std::nullopt;
+#endif
+}
+
+std::optional<MatchRange> RegexMatcher::find_next(std::string_view text, size_t start_offset) const {
+    if (!prefilter_) {
+        return search_from(text, start_offset);
+    }
+    
+    // Only run the regex on lines holding the required literal; searching
+    // the line alone keeps the engine on that line
+    size_t line_start, line_end;
+    for (size_t pos = start_offset; prefilter_->next_candidate_line(text, pos, line_start, line_end);
+         pos = line_end + 1) {
+        // The line is the whole subject, as when the engine checks a line
+        const size_t from = std::max(line_start, start_offset);
+        auto range = search_from(text.substr(line_start, line_end - line_start), from - line_start);
+        if (range) {
+            return MatchRange{range->start + line_start, range->end + line_start};
+        }
+    }
+    
+    return std::nullopt;
+}
+
+std::optional<MatchRange> RegexMatcher::search_from(std::string_view text, size_t start_offset) const {
+#ifdef HAVE_PCRE2
+    if (!is_valid() || start_offset > text.length()) {
         return std::nullopt;
     }
     
-    PCRE2_SIZE* ovector = pcre2_get_ovector_pointer(match_data_);
+    MatchScratch* scratch_space = scratch();
+    if (!scratch_space) {
+        return std::nullopt;
+    }
     
-    Match match;
-    match.start = ovector[0];
-    match.end = ovector[1];
-    match.text = text.substr(match.start, match.end - match.start);
+    int rc = run_match(text, start_offset, 0, scratch_space);
+    if (rc < 0) {
+        return std::nullopt;
+    }
     
-    return match;
+    PCRE2_SIZE* ovector = pcre2_get_ovector_pointer(scratch_space->match_data);
+    return MatchRange{ovector[0], ovector[1]};
 #else
     return std::nullopt;
 #endif
 }
 
-bool RegexMatcher::literal_match(const std::string& text, const std::string& pattern, bool case_insensitive) {
+bool RegexMatcher::literal_match(std::string_view text, std::string_view pattern, bool case_insensitive) {
     if (case_insensitive) {
         auto it = std::search(
             text.begin(), text.end(),
@@ -206,7 +363,7 @@ bool RegexMatcher::literal_match(const std::string& text, const std::string& pat
         );
         return it != text.end();
     } else {
-        return text.find(pattern) != std::string::npos;
+        return text.find(pattern) != std::string_view::npos;
     }
 }
 
@@ -0,0 +1,357 @@
+#include "regex_prefilter.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace cpp_ripgrep {
+
+namespace {
+
+constexpr size_t npos = std::string::npos;
+
+// Index just past a bracket expression starting at p[i] == '[', or npos
+size_t skip_class(const std::string& p, size_t i) {
+    size_t j = i + 1;
+    if (j < p.size() && p[j] == '^') {
+        ++j;
+    }
+    if (j < p.size() && p[j] == ']') {
+        ++j; // a leading ']' is literal
+    }
+    while (j < p.size()) {
+        if (p[j] == '\\') {
+            j += 2;
+            continue;
+        }
+        if (p[j] == '[' && j + 1 < p.size() && p[j + 1] == ':') {
+            size_t end = p.find(":]", j + 2);
+            if (end != npos) {
+                j = end + 2;
+                continue;
+            }
+        }
+        if (p[j] == ']') {
+            return j + 1;
+        }
+        ++j;
+    }
+    return npos;
+}
+
+// Index just past the group starting at p[i] == '(', or npos
+size_t skip_group(const std::string& p, size_t i) {
+    int depth = 0;
+    for (size_t j = i; j < p.size();) {
+        char c = p[j];
+        if (c == '\\') {
+            j += 2;
+            continue;
+        }
+        if (c == '[') {
+            j = skip_class(p, j);
+            if (j == npos) {
+                return npos;
+            }
+            continue;
+        }
+        if (c == '(') {
+            ++depth;
+        } else if (c == ')' && --depth == 0) {
+            return j + 1;
+        }
+        ++j;
+    }
+    return npos;
+}
+
+// Length of the quantifier at p[i] (0 if there is none); sets its minimum count
+size_t quantifier_at(const std::string& p, size_t i, size_t& min_count) {
+    if (i >= p.size()) {
+        return 0;
+    }
+
+    size_t len = 0;
+    switch (p[i]) {
+        case '*':
+        case '?':
+            min_count = 0;
+            len = 1;
+            break;
+        case '+':
+            min_count = 1;
+            len = 1;
+            break;
+        case '{': {
+            size_t j = i + 1;
+            while (j < p.size() && std::isdigit(static_cast<unsigned char>(p[j]))) {
+                ++j;
+            }
+            if (j == i + 1) {
+                return 0;
+            }
+            // Only whether the minimum is zero matters
+            min_count = p.find_first_not_of('0', i + 1) < j ? 1 : 0;
+            if (j < p.size() && p[j] == ',') {
+                ++j;
+                while (j < p.size() && std::isdigit(static_cast<unsigned char>(p[j]))) {
+                    ++j;
+                }
+            }
+            if (j >= p.size() || p[j] != '}') {
+                return 0;
+            }
+            len = j + 1 - i;
+            break;
+        }
+        default:
+            return 0;
+    }
+
+    // Lazy or possessive suffix
+    if (i + len < p.size() && (p[i + len] == '?' || p[i + len] == '+')) {
+        ++len;
+    }
+    return len;
+}
+
+// Index just past a bracketed escape argument starting at p[i], e.g. the
+// {41} of \x{41}, the <name> of \k<name>; npos if there is none
+size_t skip_bracketed(const std::string& p, size_t i) {
+    if (i >= p.size()) {
+        return npos;
+    }
+    char close;
+    switch (p[i]) {
+        case '{': close = '}'; break;
+        case '<': close = '>'; break;
+        case '\'': close = '\''; break;
+        default: return npos;
+    }
+    size_t end = p.find(close, i + 1);
+    return end == npos ? npos : end + 1;
+}
+
+// Index just past up to `max` characters from p[i] accepted by `accept`
+template <typename Accept>
+size_t skip_run(const std::string& p, size_t i, size_t max, Accept accept) {
+    size_t j = i;
+    while (j < p.size() && j - i < max && accept(static_cast<unsigned char>(p[j]))) {
+        ++j;
+    }
+    return j;
+}
+
+// Index just past an escape whose letter or digit is at p[i] (after the
+// backslash), including its argument; npos when the argument is missing
+// or not understood
+size_t skip_escape(const std::string& p, size_t i) {
+    const char escaped = p[i];
+    const size_t next = i + 1;
+    switch (escaped) {
+        case 'x': {
+            // \x{hhh} or up to two hex digits
+            if (next < p.size() && p[next] == '{') {
+                return skip_bracketed(p, next);
+            }
+            return skip_run(p, next, 2, [](unsigned char c) { return std::isxdigit(c) != 0; });
+        }
+        case 'o':
+            return skip_bracketed(p, next);
+        case 'p':
+        case 'P':
+            // \p{Name} or a one-letter property such as \pL
+            if (next < p.size() && p[next] == '{') {
+                return skip_bracketed(p, next);
+            }
+            return next < p.size() && std::isalpha(static_cast<unsigned char>(p[next])) ? next + 1 : npos;
+        case 'g': {
+            // \g{n}, \g<name>, \g'name' or a numeric reference such as \g1, \g-1
+            if (next < p.size() && (p[next] == '{' || p[next] == '<' || p[next] == '\'')) {
+                return skip_bracketed(p, next);
+            }
+            size_t digits = next < p.size() && (p[next] == '-' || p[next] == '+') ? next + 1 : next;
+            size_t end = skip_run(p, digits, npos, [](unsigned char c) { return std::isdigit(c) != 0; });
+            return end == digits ? npos : end;
+        }
+        case 'k':
+            return skip_bracketed(p, next);
+        case 'N':
+            // \N{U+hhhh} names a character; a bare \N is any non-newline
+            return next < p.size() && p[next] == '{' ? skip_bracketed(p, next) : next;
+        case 'c':
+            return next < p.size() ? next + 1 : npos;
+        default:
+            break;
+    }
+    if (std::isdigit(static_cast<unsigned char>(escaped))) {
+        // Back-reference or octal code; the digits that follow may belong to
+        // either, so all of them are consumed (dropping a literal is safe)
+        return skip_run(p, next, npos, [](unsigned char c) { return std::isdigit(c) != 0; });
+    }
+    // Classes and assertions without an argument, e.g. \d, \b, \A
+    return next;
+}
+
+// Expected candidate rate of a factor: LiteralSearcher filters on the two
+// rarest bytes, so rank a factor by those (lower is better)
+unsigned factor_cost(const std::string& factor) {
+    unsigned rarest = 255;
+    unsigned second = 255;
+    for (unsigned char byte : factor) {
+        unsigned rank = LiteralSearcher::byte_rank(byte);
+        if (rank < rarest) {
+            second = rarest;
+            rarest = rank;
+        } else if (rank < second) {
+            second = rank;
+        }
+    }
+    return rarest + second;
+}
+
+} // namespace
+
+std::vector<std::string> RegexPrefilter::required_literals(const std::string& p) {
+    std::vector<std::string> factors;
+    std::string current;
+    auto flush = [&]() {
+        if (!current.empty()) {
+            factors.push_back(current);
+            current.clear();
+        }
+    };
+
+    for (size_t i = 0; i < p.size();) {
+        const char c = p[i];
+        size_t atom_end = i + 1;
+        bool literal = false;
+        char literal_char = 0;
+
+        if (c == '|') {
+            // Top-level alternation: no single factor is required
+            return {};
+        } else if (c == '\\') {
+            if (i + 1 >= p.size()) {
+                return {};
+            }
+            const char escaped = p[i + 1];
+            atom_end = i + 2;
+            if (escaped == 'Q') {
+                // Quoted run; a following quantifier applies to its last byte
+                size_t end = p.find("\\E", i + 2);
+                std::string quoted = p.substr(i + 2, end == npos ? npos : end - i - 2);
+                atom_end = end == npos ? p.size() : end + 2;
+                if (quoted.empty() || quoted.find('\n') != npos) {
+                    flush();
+                    i = atom_end;
+                    continue;
+                }
+                current += quoted.substr(0, quoted.size() - 1);
+                literal = true;
+                literal_char = quoted.back();
+            } else if (std::isalnum(static_cast<unsigned char>(escaped))) {
+                // Class, assertion, back-reference or character code. An
+                // argument that is not understood could hide anything, even
+                // a top-level alternation, so nothing is extracted then.
+                atom_end = skip_escape(p, i + 1);
+                if (atom_end == npos || atom_end > p.size()) {
+                    return {};
+                }
+            } else {
+                literal = true;
+                literal_char = escaped;
+            }
+        } else if (c == '[') {
+            atom_end = skip_class(p, i);
+            if (atom_end == npos) {
+                return {};
+            }
+        } else if (c == '(') {
+            // Inline option settings such as (?i) change how later literals match
+            if (i + 2 < p.size() && p[i + 1] == '?' && std::strchr("imsxnUJ-^)", p[i + 2])) {
+                return {};
+            }
+            atom_end = skip_group(p, i);
+            if (atom_end == npos) {
+                return {};
+            }
+        } else if (c == ')' || c == '*' || c == '+' || c == '?' || c == '{') {
+            // Unbalanced or not following an atom
+            return {};
+        } else if (c != '.' && c != '^' && c != '$' && c != '\n') {
+            literal = true;
+            literal_char = c;
+        }
+
+        // Factors never span lines, since matching is per line
+        if (literal && literal_char == '\n') {
+            literal = false;
+        }
+
+        size_t min_count = 1;
+        size_t quantifier = quantifier_at(p, atom_end, min_count);
+        if (quantifier == 0 && atom_end < p.size() && p[atom_end] == '{') {
+            return {};
+        }
+
+        if (!literal) {
+            flush();
+        } else if (quantifier == 0) {
+            current += literal_char;
+        } else if (min_count == 0) {
+            flush();
+        } else {
+            current += literal_char;
+            flush();
+        }
+        i = atom_end + quantifier;
+    }
+    flush();
+
+    return factors;
+}
+
+std::unique_ptr<RegexPrefilter> RegexPrefilter::build(const std::string& pattern, bool case_insensitive) {
+    std::vector<std::string> factors = required_literals(pattern);
+
+    // Literal search is case sensitive, so caseless patterns can only use
+    // factors without letters
+    if (case_insensitive) {
+        factors.erase(std::remove_if(factors.begin(), factors.end(), [](const std::string& factor) {
+            return std::any_of(factor.begin(), factor.end(), [](unsigned char byte) {
+                return std::isalpha(byte);
+            });
+        }), factors.end());
+    }
+    if (factors.empty()) {
+        return nullptr;
+    }
+
+    auto best = std::min_element(factors.begin(), factors.end(),
+        [](const std::string& a, const std::string& b) {
+            return factor_cost(a) < factor_cost(b);
+        });
+    return std::unique_ptr<RegexPrefilter>(new RegexPrefilter(*best));
+}
+
+RegexPrefilter::RegexPrefilter(std::string literal) : searcher_(std::move(literal)) {}
+
+bool RegexPrefilter::next_candidate_line(std::string_view text, size_t from,
+                                         size_t& line_start, size_t& line_end) const {
+    size_t hit = searcher_.find(text, from);
+    if (hit == LiteralSearcher::npos) {
+        return false;
+    }
+
+    line_start = hit;
+    while (line_start > from && text[line_start - 1] != '\n') {
+        --line_start;
+    }
+    line_end = text.find('\n', hit);
+    if (line_end == std::string_view::npos) {
+        line_end = text.size();
+    }
+    return true;
+}
+
+} // namespace cpp_ripgrep
@@ -0,0 +1,144 @@
+#include "regex_set_matcher.hpp"
+#include <algorithm>
+#include <iterator>
+
+namespace cpp_ripgrep {
+
+namespace {
+
+// Source bytes per program. Compiled code runs to about 1.5 times the
+// source, so this stays clear of PCRE2's 64 KiB limit for plain patterns;
+// groups that still do not fit are split further.
+constexpr size_t kProgramSourceSize = 32 * 1024;
+
+} // namespace
+
+RegexSetMatcher::RegexSetMatcher(const std::vector<std::string>& patterns, bool case_insensitive) {
+    size_t begin = 0;
+    size_t source_size = 0;
+    for (size_t i = 0; i < patterns.size(); ++i) {
+        // Room for the "(*MARK:n)(?:...)|" wrapping of each pattern
+        const size_t size = patterns[i].size() + 24;
+        if (i > begin && source_size + size > kProgramSourceSize) {
+            if (!compile_group(patterns, begin, i, case_insensitive)) {
+                return;
+            }
+            begin = i;
+            source_size = 0;
+        }
+        source_size += size;
+    }
+    if (begin < patterns.size()) {
+        compile_group(patterns, begin, patterns.size(), case_insensitive);
+    }
+}
+
+bool RegexSetMatcher::compile_group(const std::vector<std::string>& patterns, size_t begin, size_t end,
+                                    bool case_insensitive) {
+    auto program = std::make_unique<RegexMatcher>(RegexMatcher::tagged_alternation(patterns, begin, end),
+                                                  case_insensitive);
+    if (program->is_valid()) {
+        programs_.push_back(std::move(program));
+        return true;
+    }
+    if (end - begin == 1) {
+        error_ = "pattern " + std::to_string(begin) + ": " + program->get_error();
+        programs_.clear();
+        return false;
+    }
+
+    const size_t middle = begin + (end - begin) / 2;
+    return compile_group(patterns, begin, middle, case_insensitive) &&
+           compile_group(patterns, middle, end, case_insensitive);
+}
+
+std::vector<Match> RegexSetMatcher::find_all(std::string_view text) const {
+    if (programs_.size() == 1) {
+        return programs_.front()->find_all(text);
+    }
+
+    std::vector<Match> candidates;
+    for (const auto& program : programs_) {
+        auto found = program->find_all(text);
+        std::move(found.begin(), found.end(), std::back_inserter(candidates));
+    }
+
+    // One program picks the first alternative that matches at the leftmost
+    // position; keep that order across programs
+    std::sort(candidates.begin(), candidates.end(), [](const Match& a, const Match& b) {
+        if (a.start != b.start) {
+            return a.start < b.start;
+        }
+        return a.pattern_index < b.pattern_index;
+    });
+
+    std::vector<Match> matches;
+    for (auto& match : candidates) {
+        if (!matches.empty() && match.start < matches.back().end) {
+            continue;
+        }
+        if (!matches.empty() && match.start == match.end && match.start == matches.back().start) {
+            continue;
+        }
+        matches.push_back(std::move(match));
+    }
+
+    return matches;
+}
+
+bool RegexSetMatcher::matches(std::string_view text) const {
+    for (const auto& program : programs_) {
+        if (program->matches(text)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::optional<MatchRange> RegexSetMatcher::find_next(std::string_view text, size_t start_offset) const {
+    std::optional<MatchRange> best;
+    for (const auto& program : programs_) {
+        auto range = program->find_next(text, start_offset);
+        if (range && (!best || range->start < best->start)) {
+            best = range;
+        }
+    }
+    return best;
+}
+
+RegexSetMatcher::Cursor RegexSetMatcher::scan(std::string_view text) const {
+    return Cursor(*this, text);
+}
+
+RegexSetMatcher::Cursor::Cursor(const RegexSetMatcher& matcher, std::string_view text)
+    : text_(text) {
+    pending_.reserve(matcher.programs_.size());
+    for (const auto& program : matcher.programs_) {
+        pending_.push_back(Pending{program.get(), false, MatchRange{0, 0}});
+    }
+}
+
+std::optional<MatchRange> RegexSetMatcher::Cursor::next(size_t from) {
+    std::optional<MatchRange> best;
+
+    for (auto it = pending_.begin(); it != pending_.end();) {
+        // Programs whose next match is still ahead of `from` need no new search
+        if (!it->searched || it->range.start < from) {
+            auto range = it->program->find_next(text_, from);
+            if (!range) {
+                it = pending_.erase(it);
+                continue;
+            }
+            it->range = *range;
+            it->searched = true;
+        }
+        if (!best || it->range.start < best->start) {
+            best = it->range;
+        }
+        ++it;
+    }
+
+    return best;
+}
+
+} // namespace cpp_ripgrep
@@ -0,0 +1,31 @@
+#include "reorder_buffer.hpp"
+#include <algorithm>
+
+namespace cpp_ripgrep {
+
+ReorderBuffer::ReorderBuffer(std::function<void(const std::string&)> emit, size_t window)
+    : emit_(std::move(emit)), window_(std::max<size_t>(window, 1)) {}
+
+void ReorderBuffer::wait_for_slot(size_t sequence) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    slot_cv_.wait(lock, [&] { return sequence < next_ + window_; });
+}
+
+void ReorderBuffer::submit(size_t sequence, std::string batch) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (sequence != next_) {
+        pending_.emplace(sequence, std::move(batch));
+        return;
+    }
+    
+    // Emitting under the lock keeps batches from interleaving
+    emit_(batch);
+    ++next_;
+    for (auto it = pending_.begin(); it != pending_.end() && it->first == next_; it = pending_.erase(it)) {
+        emit_(it->second);
+        ++next_;
+    }
+    slot_cv_.notify_all();
+}
+
+} // namespace cpp_ripgrep
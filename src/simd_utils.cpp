@@ -0,0 +1,194 @@
+#include "simd_utils.hpp"
+#include <cstdint>
+#include <cstring>
+
+#ifdef CPP_RIPGREP_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace cpp_ripgrep {
+namespace simd {
+
+namespace {
+
+size_t count_byte_scalar(const char* data, size_t size, char byte) {
+    size_t count = 0;
+    for (size_t i = 0; i < size; ++i) {
+        count += data[i] == byte;
+    }
+    return count;
+}
+
+size_t find_any_of_scalar(const char* data, size_t size, size_t from, std::string_view bytes) {
+    if (bytes.size() == 1) {
+        const void* hit = std::memchr(data + from, bytes[0], size - from);
+        return hit ? static_cast<const char*>(hit) - data : std::string_view::npos;
+    }
+    for (size_t i = from; i < size; ++i) {
+        if (bytes.find(data[i]) != std::string_view::npos) {
+            return i;
+        }
+    }
+    return std::string_view::npos;
+}
+
+#ifdef CPP_RIPGREP_X86_DISPATCH
+
+// Byte-wise equality results are accumulated in 8-bit lanes (subtracting the
+// all-ones compare mask adds one) and folded into 64-bit sums with SAD every
+// 255 blocks, before any lane can overflow.
+
+__attribute__((target("sse2")))
+size_t count_byte_sse2(const char* data, size_t size, char byte) {
+    const __m128i needle = _mm_set1_epi8(byte);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i totals = _mm_setzero_si128();
+    size_t i = 0;
+    
+    while (i + 16 <= size) {
+        __m128i counters = _mm_setzero_si128();
+        size_t blocks = 0;
+        for (; blocks < 255 && i + 16 <= size; ++blocks, i += 16) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            counters = _mm_sub_epi8(counters, _mm_cmpeq_epi8(chunk, needle));
+        }
+        totals = _mm_add_epi64(totals, _mm_sad_epu8(counters, zero));
+    }
+    
+    uint64_t lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), totals);
+    return static_cast<size_t>(lanes[0] + lanes[1]) + count_byte_scalar(data + i, size - i, byte);
+}
+
+__attribute__((target("avx2")))
+size_t count_byte_avx2(const char* data, size_t size, char byte) {
+    const __m256i needle = _mm256_set1_epi8(byte);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i totals = _mm256_setzero_si256();
+    size_t i = 0;
+    
+    while (i + 32 <= size) {
+        __m256i counters = _mm256_setzero_si256();
+        size_t blocks = 0;
+        for (; blocks < 255 && i + 32 <= size; ++blocks, i += 32) {
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            counters = _mm256_sub_epi8(counters, _mm256_cmpeq_epi8(chunk, needle));
+        }
+        totals = _mm256_add_epi64(totals, _mm256_sad_epu8(counters, zero));
+    }
+    
+    uint64_t lanes[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), totals);
+    return static_cast<size_t>(lanes[0] + lanes[1] + lanes[2] + lanes[3]) +
+           count_byte_sse2(data + i, size - i, byte);
+}
+
+// Unused needle slots repeat the first byte so they never add false hits
+
+__attribute__((target("sse2")))
+size_t find_any_of_sse2(const char* data, size_t size, size_t from, std::string_view bytes) {
+    const __m128i b0 = _mm_set1_epi8(bytes[0]);
+    const __m128i b1 = _mm_set1_epi8(bytes[bytes.size() > 1 ? 1 : 0]);
+    const __m128i b2 = _mm_set1_epi8(bytes[bytes.size() > 2 ? 2 : 0]);
+    
+    size_t i = from;
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, b0),
+                                    _mm_or_si128(_mm_cmpeq_epi8(chunk, b1), _mm_cmpeq_epi8(chunk, b2)));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hits));
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return find_any_of_scalar(data, size, i, bytes);
+}
+
+__attribute__((target("avx2")))
+size_t find_any_of_avx2(const char* data, size_t size, size_t from, std::string_view bytes) {
+    const __m256i b0 = _mm256_set1_epi8(bytes[0]);
+    const __m256i b1 = _mm256_set1_epi8(bytes[bytes.size() > 1 ? 1 : 0]);
+    const __m256i b2 = _mm256_set1_epi8(bytes[bytes.size() > 2 ? 2 : 0]);
+    
+    size_t i = from;
+    for (; i + 32 <= size; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, b0),
+                                       _mm256_or_si256(_mm256_cmpeq_epi8(chunk, b1), _mm256_cmpeq_epi8(chunk, b2)));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hits));
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return find_any_of_sse2(data, size, i, bytes);
+}
+
+#endif // CPP_RIPGREP_X86_DISPATCH
+
+Level detect_level() {
+#ifdef CPP_RIPGREP_X86_DISPATCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return Level::AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return Level::SSE2;
+    }
+#endif
+    return Level::SCALAR;
+}
+
+} // namespace
+
+Level cpu_level() {
+    static const Level level = detect_level();
+    return level;
+}
+
+size_t count_byte(std::string_view text, char byte) {
+    switch (cpu_level()) {
+#ifdef CPP_RIPGREP_X86_DISPATCH
+        case Level::AVX2:
+            return count_byte_avx2(text.data(), text.size(), byte);
+        case Level::SSE2:
+            return count_byte_sse2(text.data(), text.size(), byte);
+#endif
+        default:
+            return count_byte_scalar(text.data(), text.size(), byte);
+    }
+}
+
+size_t find_any_of(std::string_view text, size_t from, std::string_view bytes) {
+    if (from >= text.size() || bytes.empty()) {
+        return std::string_view::npos;
+    }
+    // A single byte is best served by the C library's memchr
+    if (bytes.size() == 1) {
+        return find_any_of_scalar(text.data(), text.size(), from, bytes);
+    }
+    
+    switch (cpu_level()) {
+#ifdef CPP_RIPGREP_X86_DISPATCH
+        case Level::AVX2:
+            return find_any_of_avx2(text.data(), text.size(), from, bytes);
+        case Level::SSE2:
+            return find_any_of_sse2(text.data(), text.size(), from, bytes);
+#endif
+        default:
+            return find_any_of_scalar(text.data(), text.size(), from, bytes);
+    }
+}
+
+const char* implementation_name() {
+    switch (cpu_level()) {
+        case Level::AVX2:
+            return "avx2";
+        case Level::SSE2:
+            return "sse2";
+        default:
+            return "scalar";
+    }
+}
+
+} // namespace simd
+} // namespace cpp_ripgrep
@@ -0,0 +1,602 @@
+#include "trigram_index.hpp"
+#include "options.hpp"
+#include "regex_prefilter.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace cpp_ripgrep {
+
+struct TrigramIndex::Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t file_count;
+    uint64_t trigram_count;
+    uint64_t files_offset;
+    uint64_t order_offset;
+    uint64_t strings_offset;
+    uint64_t strings_size;
+    uint64_t trigrams_offset;
+    uint64_t postings_offset;
+    uint64_t postings_size;
+};
+
+struct TrigramIndex::FileEntry {
+    uint64_t path_offset;
+    uint32_t path_length;
+    uint32_t reserved;
+    uint64_t size;
+    int64_t mtime;
+};
+
+struct TrigramIndex::TrigramEntry {
+    uint32_t trigram;
+    uint32_t count;
+    uint64_t offset;   // into the postings section
+};
+
+namespace {
+
+constexpr char kMagic[8] = {'C', 'R', 'G', 'I', 'D', 'X', '\0', '\0'};
+constexpr uint32_t kVersion = 1;
+
+size_t align8(size_t offset) {
+    return (offset + 7) & ~static_cast<size_t>(7);
+}
+
+void put_varint(std::string& out, uint32_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+size_t varint_length(uint32_t value) {
+    size_t length = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++length;
+    }
+    return length;
+}
+
+// Decode count varint deltas from [p, end); false if they run past end
+bool decode_postings(const unsigned char* p, const unsigned char* end, uint32_t count,
+                     std::vector<uint32_t>& ids) {
+    ids.clear();
+    ids.reserve(count);
+    uint32_t id = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t delta = 0;
+        for (unsigned shift = 0;; shift += 7) {
+            if (p == end || shift > 28) {
+                return false;
+            }
+            const unsigned char byte = *p++;
+            delta |= static_cast<uint32_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                break;
+            }
+        }
+        id += delta;
+        ids.push_back(id);
+    }
+    return true;
+}
+
+// Bytes a caseless match need not contain as they are: letters that some
+// Unicode characters fold to (U+017F long s, U+212A Kelvin sign), and any
+// byte of a multi-byte character, since the index folds ASCII only while
+// the regex engines fold É to é and the like
+bool has_special_fold(uint32_t trigram) {
+    for (int shift = 0; shift <= 16; shift += 8) {
+        const unsigned char byte = static_cast<unsigned char>(trigram >> shift);
+        if (byte == 'k' || byte == 's' || byte >= 0x80) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+std::optional<FileStamp> FileStamp::of(const std::string& path) {
+    FileStamp stamp;
+#ifdef _WIN32
+    std::error_code error;
+    auto size = std::filesystem::file_size(path, error);
+    if (error) {
+        return std::nullopt;
+    }
+    auto mtime = std::filesystem::last_write_time(path, error);
+    if (error) {
+        return std::nullopt;
+    }
+    stamp.size = size;
+    stamp.mtime = static_cast<int64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(mtime.time_since_epoch()).count());
+#else
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) {
+        return std::nullopt;
+    }
+    stamp.size = static_cast<uint64_t>(st.st_size);
+#ifdef __APPLE__
+    stamp.mtime = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    stamp.mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+#endif
+    return stamp;
+}
+
+TrigramQuery TrigramQuery::plan(const Options& options) {
+    TrigramQuery query;
+
+    // A non-matching line can be anywhere
+    if (options.invert_match) {
+        return query;
+    }
+
+    const bool literal = options.mode == SearchMode::LITERAL || options.mode == SearchMode::MULTI_LITERAL;
+    for (const auto& pattern : options.patterns) {
+        std::vector<std::string> factors = literal ? std::vector<std::string>{pattern}
+                                                   : RegexPrefilter::required_literals(pattern);
+        std::vector<uint32_t> trigrams;
+        for (const auto& factor : factors) {
+            for (size_t i = 0; i + 3 <= factor.size(); ++i) {
+                if (std::memchr(factor.data() + i, '\n', 3)) {
+                    continue;
+                }
+                uint32_t trigram = TrigramIndex::make_trigram(factor[i], factor[i + 1], factor[i + 2]);
+                if (options.ignore_case && has_special_fold(trigram)) {
+                    continue;
+                }
+                trigrams.push_back(trigram);
+            }
+        }
+        std::sort(trigrams.begin(), trigrams.end());
+        trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+
+        // One unconstrained alternative makes every file a candidate
+        if (trigrams.empty()) {
+            return TrigramQuery();
+        }
+        query.alternatives.push_back(std::move(trigrams));
+    }
+
+    query.match_all = query.alternatives.empty();
+    return query;
+}
+
+uint32_t TrigramIndex::make_trigram(unsigned char a, unsigned char b, unsigned char c) {
+    auto fold = [](unsigned char byte) -> uint32_t {
+        return byte >= 'A' && byte <= 'Z' ? byte + ('a' - 'A') : byte;
+    };
+    return (fold(a) << 16) | (fold(b) << 8) | fold(c);
+}
+
+std::string_view TrigramIndex::normalize_path(std::string_view path) {
+    while (path.size() >= 2 && path[0] == '.' && path[1] == '/') {
+        path.remove_prefix(2);
+    }
+    return path;
+}
+
+std::unique_ptr<TrigramIndex> TrigramIndex::open(const std::string& path, std::string& error) {
+    std::unique_ptr<TrigramIndex> index(new TrigramIndex());
+
+#ifdef _WIN32
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = "cannot open " + path;
+        return nullptr;
+    }
+    index->data_ = FileBuffer::from_string(std::string(std::istreambuf_iterator<char>(file),
+                                                       std::istreambuf_iterator<char>()));
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        error = "cannot open " + path + ": " + std::strerror(errno);
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size <= 0) {
+        close(fd);
+        error = "cannot read " + path;
+        return nullptr;
+    }
+    void* mapped = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        error = "cannot map " + path + ": " + std::strerror(errno);
+        return nullptr;
+    }
+    index->data_ = FileBuffer::from_mapping(mapped, static_cast<size_t>(st.st_size));
+#endif
+
+    if (!index->validate(error)) {
+        error = path + ": " + error;
+        return nullptr;
+    }
+    return index;
+}
+
+bool TrigramIndex::validate(std::string& error) {
+    const size_t size = data_.size();
+    const char* base = data_.data();
+    if (size < sizeof(Header) || reinterpret_cast<uintptr_t>(base) % 8 != 0) {
+        error = "not an index file";
+        return false;
+    }
+
+    header_ = reinterpret_cast<const Header*>(base);
+    if (std::memcmp(header_->magic, kMagic, sizeof(kMagic)) != 0) {
+        error = "not an index file";
+        return false;
+    }
+    if (header_->version != kVersion) {
+        error = "unsupported index version " + std::to_string(header_->version);
+        return false;
+    }
+
+    auto section_fits = [&](uint64_t offset, uint64_t length) {
+        return offset % 8 == 0 && offset <= size && length <= size - offset;
+    };
+    const uint64_t files = header_->file_count;
+    if (!section_fits(header_->files_offset, files * sizeof(FileEntry)) ||
+        !section_fits(header_->order_offset, files * sizeof(uint32_t)) ||
+        !section_fits(header_->strings_offset, header_->strings_size) ||
+        !section_fits(header_->trigrams_offset, header_->trigram_count * sizeof(TrigramEntry)) ||
+        !section_fits(header_->postings_offset, header_->postings_size)) {
+        error = "index file is truncated or corrupt";
+        return false;
+    }
+
+    files_ = reinterpret_cast<const FileEntry*>(base + header_->files_offset);
+    order_ = reinterpret_cast<const uint32_t*>(base + header_->order_offset);
+    strings_ = base + header_->strings_offset;
+    trigrams_ = reinterpret_cast<const TrigramEntry*>(base + header_->trigrams_offset);
+    postings_ = reinterpret_cast<const unsigned char*>(base + header_->postings_offset);
+
+    for (uint64_t i = 0; i < files; ++i) {
+        const FileEntry& entry = files_[i];
+        if (entry.path_offset > header_->strings_size ||
+            entry.path_length > header_->strings_size - entry.path_offset || order_[i] >= files) {
+            error = "index file is corrupt";
+            return false;
+        }
+    }
+    for (uint64_t i = 0; i < header_->trigram_count; ++i) {
+        if (trigrams_[i].offset > header_->postings_size) {
+            error = "index file is corrupt";
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t TrigramIndex::file_count() const {
+    return header_->file_count;
+}
+
+std::string_view TrigramIndex::path(uint32_t id) const {
+    return std::string_view(strings_ + files_[id].path_offset, files_[id].path_length);
+}
+
+FileStamp TrigramIndex::stamp(uint32_t id) const {
+    FileStamp stamp;
+    stamp.size = files_[id].size;
+    stamp.mtime = files_[id].mtime;
+    return stamp;
+}
+
+uint32_t TrigramIndex::find(std::string_view file_path) const {
+    file_path = normalize_path(file_path);
+    const uint32_t* begin = order_;
+    const uint32_t* end = order_ + header_->file_count;
+    const uint32_t* it = std::lower_bound(begin, end, file_path, [this](uint32_t id, std::string_view key) {
+        return path(id) < key;
+    });
+    if (it != end && path(*it) == file_path) {
+        return *it;
+    }
+    return kNoFile;
+}
+
+std::vector<uint32_t> TrigramIndex::postings(uint32_t trigram) const {
+    std::vector<uint32_t> ids;
+    const TrigramEntry* begin = trigrams_;
+    const TrigramEntry* end = trigrams_ + header_->trigram_count;
+    const TrigramEntry* it = std::lower_bound(begin, end, trigram, [](const TrigramEntry& entry, uint32_t key) {
+        return entry.trigram < key;
+    });
+    if (it == end || it->trigram != trigram) {
+        return ids;
+    }
+
+    if (!decode_postings(postings_ + it->offset, postings_ + header_->postings_size, it->count, ids)) {
+        ids.clear();
+    }
+    // Corrupt ids must not index past the file table
+    if (!ids.empty() && ids.back() >= header_->file_count) {
+        ids.clear();
+    }
+    return ids;
+}
+
+std::vector<bool> TrigramIndex::candidates(const TrigramQuery& query) const {
+    std::vector<bool> result(header_->file_count, query.match_all);
+    if (query.match_all) {
+        return result;
+    }
+
+    std::vector<uint32_t> next;
+    for (const auto& alternative : query.alternatives) {
+        // Intersect every trigram's posting list; a missing trigram rules
+        // the alternative out
+        std::vector<uint32_t> ids;
+        bool first = true;
+        for (uint32_t trigram : alternative) {
+            std::vector<uint32_t> list = postings(trigram);
+            if (first) {
+                ids = std::move(list);
+                first = false;
+            } else {
+                next.clear();
+                std::set_intersection(ids.begin(), ids.end(), list.begin(), list.end(), std::back_inserter(next));
+                ids.swap(next);
+            }
+            if (ids.empty()) {
+                break;
+            }
+        }
+        for (uint32_t id : ids) {
+            result[id] = true;
+        }
+    }
+    return result;
+}
+
+TrigramCollector::TrigramCollector() : seen_((1u << 24) / 64, 0) {}
+
+void TrigramCollector::add(std::string_view text) {
+    if (text.size() < 3) {
+        return;
+    }
+
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(text.data());
+    for (size_t i = 0; i + 3 <= text.size(); ++i) {
+        if (p[i] == '\n' || p[i + 1] == '\n' || p[i + 2] == '\n') {
+            continue;
+        }
+        const uint32_t trigram = TrigramIndex::make_trigram(p[i], p[i + 1], p[i + 2]);
+        uint64_t& word = seen_[trigram >> 6];
+        const uint64_t bit = uint64_t(1) << (trigram & 63);
+        if (!(word & bit)) {
+            word |= bit;
+            found_.push_back(trigram);
+        }
+    }
+}
+
+std::vector<uint32_t> TrigramCollector::take() {
+    for (uint32_t trigram : found_) {
+        seen_[trigram >> 6] = 0;
+    }
+    std::vector<uint32_t> trigrams;
+    trigrams.swap(found_);
+    std::sort(trigrams.begin(), trigrams.end());
+    return trigrams;
+}
+
+TrigramIndexBuilder::TrigramIndexBuilder(const TrigramIndex* previous) : previous_(previous) {}
+
+bool TrigramIndexBuilder::reuse(std::string_view path, const FileStamp& stamp) {
+    if (!previous_) {
+        return false;
+    }
+    uint32_t id = previous_->find(path);
+    if (id == TrigramIndex::kNoFile || !(previous_->stamp(id) == stamp)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    reused_.push_back(id);
+    return true;
+}
+
+void TrigramIndexBuilder::add(std::string_view path, const FileStamp& stamp,
+                              const std::vector<uint32_t>& trigrams) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const uint32_t id = static_cast<uint32_t>(added_.size());
+    added_.push_back(AddedFile{std::string(TrigramIndex::normalize_path(path)), stamp});
+
+    for (uint32_t trigram : trigrams) {
+        Postings& list = postings_[trigram];
+        put_varint(list.bytes, list.count == 0 ? id : id - list.last);
+        if (list.count == 0) {
+            list.first = id;
+        }
+        list.last = id;
+        ++list.count;
+    }
+}
+
+bool TrigramIndexBuilder::write(const std::string& path, std::string& error) {
+    using Header = TrigramIndex::Header;
+    using FileEntry = TrigramIndex::FileEntry;
+    using TrigramEntry = TrigramIndex::TrigramEntry;
+
+    // Unchanged files keep their relative order and come first, so their
+    // posting lists carry over with ids remapped; added files follow
+    std::sort(reused_.begin(), reused_.end());
+    reused_.erase(std::unique(reused_.begin(), reused_.end()), reused_.end());
+    const uint32_t reused_count = static_cast<uint32_t>(reused_.size());
+    const uint32_t file_count = reused_count + static_cast<uint32_t>(added_.size());
+
+    std::vector<uint32_t> remap;
+    if (previous_) {
+        remap.assign(previous_->file_count(), TrigramIndex::kNoFile);
+        for (uint32_t i = 0; i < reused_count; ++i) {
+            remap[reused_[i]] = i;
+        }
+    }
+
+    // File table and path strings
+    std::vector<FileEntry> files(file_count);
+    std::string strings;
+    auto add_file = [&](uint32_t id, std::string_view file_path, const FileStamp& stamp) {
+        FileEntry& entry = files[id];
+        entry.path_offset = strings.size();
+        entry.path_length = static_cast<uint32_t>(file_path.size());
+        entry.reserved = 0;
+        entry.size = stamp.size;
+        entry.mtime = stamp.mtime;
+        strings.append(file_path.data(), file_path.size());
+    };
+    for (uint32_t i = 0; i < reused_count; ++i) {
+        add_file(i, previous_->path(reused_[i]), previous_->stamp(reused_[i]));
+    }
+    for (size_t i = 0; i < added_.size(); ++i) {
+        add_file(reused_count + static_cast<uint32_t>(i), added_[i].path, added_[i].stamp);
+    }
+
+    std::vector<uint32_t> order(file_count);
+    for (uint32_t i = 0; i < file_count; ++i) {
+        order[i] = i;
+    }
+    auto path_of = [&](uint32_t id) {
+        return std::string_view(strings.data() + files[id].path_offset, files[id].path_length);
+    };
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return path_of(a) < path_of(b); });
+
+    // Merge the previous index's trigrams with the new ones
+    std::vector<uint32_t> new_trigrams;
+    new_trigrams.reserve(postings_.size());
+    for (const auto& entry : postings_) {
+        new_trigrams.push_back(entry.first);
+    }
+    std::sort(new_trigrams.begin(), new_trigrams.end());
+
+    std::vector<uint32_t> old_trigrams;
+    if (previous_ && reused_count > 0) {
+        const auto* table = previous_->trigrams_;
+        for (uint64_t i = 0; i < previous_->header_->trigram_count; ++i) {
+            old_trigrams.push_back(table[i].trigram);
+        }
+    }
+
+    std::vector<uint32_t> all_trigrams;
+    std::set_union(old_trigrams.begin(), old_trigrams.end(), new_trigrams.begin(), new_trigrams.end(),
+                   std::back_inserter(all_trigrams));
+
+    std::vector<TrigramEntry> trigrams;
+    trigrams.reserve(all_trigrams.size());
+    std::string postings;
+    std::vector<uint32_t> old_ids;
+    for (uint32_t trigram : all_trigrams) {
+        TrigramEntry entry;
+        entry.trigram = trigram;
+        entry.count = 0;
+        entry.offset = postings.size();
+
+        uint32_t last = 0;
+        if (!old_trigrams.empty()) {
+            old_ids = previous_->postings(trigram);
+            for (uint32_t old_id : old_ids) {
+                const uint32_t id = remap[old_id];
+                if (id == TrigramIndex::kNoFile) {
+                    continue;
+                }
+                put_varint(postings, entry.count == 0 ? id : id - last);
+                last = id;
+                ++entry.count;
+            }
+        }
+
+        auto added = postings_.find(trigram);
+        if (added != postings_.end()) {
+            // Only the first delta changes when the ids move up by reused_count
+            const Postings& list = added->second;
+            const uint32_t first = reused_count + list.first;
+            put_varint(postings, entry.count == 0 ? first : first - last);
+            postings.append(list.bytes, varint_length(list.first), std::string::npos);
+            entry.count += list.count;
+        }
+
+        if (entry.count > 0) {
+            trigrams.push_back(entry);
+        }
+    }
+
+    // Lay the sections out
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.file_count = file_count;
+    header.trigram_count = trigrams.size();
+    header.files_offset = align8(sizeof(Header));
+    header.order_offset = align8(header.files_offset + files.size() * sizeof(FileEntry));
+    header.strings_offset = align8(header.order_offset + order.size() * sizeof(uint32_t));
+    header.strings_size = strings.size();
+    header.trigrams_offset = align8(header.strings_offset + strings.size());
+    header.postings_offset = align8(header.trigrams_offset + trigrams.size() * sizeof(TrigramEntry));
+    header.postings_size = postings.size();
+
+    const std::string temp_path = path + ".tmp";
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            error = "cannot create " + temp_path;
+            return false;
+        }
+
+        size_t written = 0;
+        auto write_section = [&](uint64_t offset, const void* data, size_t length) {
+            static const char padding[8] = {};
+            out.write(padding, static_cast<std::streamsize>(offset - written));
+            out.write(static_cast<const char*>(data), static_cast<std::streamsize>(length));
+            written = offset + length;
+        };
+        write_section(0, &header, sizeof(header));
+        write_section(header.files_offset, files.data(), files.size() * sizeof(FileEntry));
+        write_section(header.order_offset, order.data(), order.size() * sizeof(uint32_t));
+        write_section(header.strings_offset, strings.data(), strings.size());
+        write_section(header.trigrams_offset, trigrams.data(), trigrams.size() * sizeof(TrigramEntry));
+        write_section(header.postings_offset, postings.data(), postings.size());
+
+        out.flush();
+        if (!out) {
+            error = "cannot write " + temp_path;
+            std::remove(temp_path.c_str());
+            return false;
+        }
+    }
+
+    std::error_code rename_error;
+    std::filesystem::rename(temp_path, path, rename_error);
+    if (rename_error) {
+        error = "cannot replace " + path + ": " + rename_error.message();
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace cpp_ripgrep
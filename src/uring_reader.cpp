@@ -0,0 +1,343 @@
+#include "uring_reader.hpp"
+#include <algorithm>
+
+#ifdef CPP_RIPGREP_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/stat.h>
+#include <unistd.h>
+
+static_assert(sizeof(struct statx) <= 256, "statx buffer too small");
+#endif
+
+namespace cpp_ripgrep {
+
+#ifdef CPP_RIPGREP_IO_URING
+
+namespace {
+
+int uring_setup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+template <typename T>
+T* ring_field(void* ring, uint32_t offset) {
+    return reinterpret_cast<T*>(static_cast<char*>(ring) + offset);
+}
+
+} // namespace
+
+bool UringReader::available() {
+    static const bool supported = [] {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        int fd = uring_setup(2, &params);
+        if (fd < 0) {
+            return false;
+        }
+        close(fd);
+        // openat/statx/read as ring operations arrived together in 5.6,
+        // along with IORING_FEAT_NODROP
+        return (params.features & IORING_FEAT_NODROP) != 0;
+    }();
+    return supported;
+}
+
+UringReader::UringReader(unsigned depth, size_t max_size) : max_size_(max_size) {
+    if (depth == 0 || !available()) {
+        return;
+    }
+
+    // Every file has at most two operations queued at once
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    int fd = uring_setup(depth * 2, &params);
+    if (fd < 0) {
+        return;
+    }
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+        sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    fd, IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+        sq_ring_ = nullptr;
+        close(fd);
+        return;
+    }
+    if (single_mmap) {
+        cq_ring_ = sq_ring_;
+    } else {
+        cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        fd, IORING_OFF_CQ_RING);
+        if (cq_ring_ == MAP_FAILED) {
+            cq_ring_ = nullptr;
+            munmap(sq_ring_, sq_ring_size_);
+            sq_ring_ = nullptr;
+            close(fd);
+            return;
+        }
+    }
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        if (cq_ring_ != sq_ring_) {
+            munmap(cq_ring_, cq_ring_size_);
+        }
+        munmap(sq_ring_, sq_ring_size_);
+        sq_ring_ = cq_ring_ = nullptr;
+        close(fd);
+        return;
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    sq_head_ = ring_field<unsigned>(sq_ring_, params.sq_off.head);
+    sq_tail_ = ring_field<unsigned>(sq_ring_, params.sq_off.tail);
+    sq_mask_ = ring_field<unsigned>(sq_ring_, params.sq_off.ring_mask);
+    sq_array_ = ring_field<unsigned>(sq_ring_, params.sq_off.array);
+    cq_head_ = ring_field<unsigned>(cq_ring_, params.cq_off.head);
+    cq_tail_ = ring_field<unsigned>(cq_ring_, params.cq_off.tail);
+    cq_mask_ = ring_field<unsigned>(cq_ring_, params.cq_off.ring_mask);
+    cqes_ = ring_field<io_uring_cqe>(cq_ring_, params.cq_off.cqes);
+
+    requests_.resize(depth);
+    for (size_t slot = depth; slot > 0; --slot) {
+        free_slots_.push_back(slot - 1);
+    }
+    ring_fd_ = fd;
+}
+
+UringReader::~UringReader() {
+    if (ring_fd_ < 0) {
+        return;
+    }
+
+    // Let the kernel finish with buffers it may still be writing into
+    while (in_flight_ > 0) {
+        std::vector<Completed> discarded;
+        reap(discarded, true);
+    }
+
+    munmap(sqes_, sqes_size_);
+    if (cq_ring_ != sq_ring_) {
+        munmap(cq_ring_, cq_ring_size_);
+    }
+    munmap(sq_ring_, sq_ring_size_);
+    close(ring_fd_);
+}
+
+io_uring_sqe* UringReader::next_sqe() {
+    unsigned tail = *sq_tail_;
+    if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) > *sq_mask_) {
+        // Ring full: hand what is queued to the kernel first
+        uring_enter(ring_fd_, to_submit_, 0, 0);
+        to_submit_ = 0;
+    }
+
+    unsigned index = tail & *sq_mask_;
+    io_uring_sqe* sqe = &sqes_[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    ++to_submit_;
+    return sqe;
+}
+
+bool UringReader::submit(std::string path) {
+    if (ring_fd_ < 0 || free_slots_.empty()) {
+        return false;
+    }
+
+    size_t slot = free_slots_.back();
+    free_slots_.pop_back();
+    Request& request = requests_[slot];
+    request = Request();
+    request.path = std::move(path);
+    request.active = true;
+    ++in_flight_;
+
+    // Open and stat by path at the same time; the read needs both
+    io_uring_sqe* open = next_sqe();
+    open->opcode = IORING_OP_OPENAT;
+    open->fd = AT_FDCWD;
+    open->addr = reinterpret_cast<uint64_t>(request.path.c_str());
+    open->open_flags = O_RDONLY | O_CLOEXEC;
+    open->user_data = (slot << 2) | OPEN;
+
+    io_uring_sqe* stat = next_sqe();
+    stat->opcode = IORING_OP_STATX;
+    stat->fd = AT_FDCWD;
+    stat->addr = reinterpret_cast<uint64_t>(request.path.c_str());
+    stat->len = STATX_SIZE;
+    stat->off = reinterpret_cast<uint64_t>(request.stat);
+    stat->user_data = (slot << 2) | STAT;
+
+    request.outstanding = 2;
+    return true;
+}
+
+void UringReader::queue_read(size_t slot) {
+    Request& request = requests_[slot];
+    io_uring_sqe* read = next_sqe();
+    read->opcode = IORING_OP_READ;
+    read->fd = request.fd;
+    read->addr = reinterpret_cast<uint64_t>(&request.data[request.filled]);
+    read->len = static_cast<uint32_t>(std::min<size_t>(request.data.size() - request.filled, 1u << 30));
+    read->off = request.filled;
+    read->user_data = (slot << 2) | READ;
+    ++request.outstanding;
+}
+
+void UringReader::reap(std::vector<Completed>& done, bool wait) {
+    if (ring_fd_ < 0 || in_flight_ == 0) {
+        return;
+    }
+
+    const size_t before = done.size();
+    while (true) {
+        // Submit queued operations, blocking for a completion if still needed
+        const bool block = wait && done.size() == before && in_flight_ > 0;
+        if (to_submit_ > 0 || block) {
+            int result = uring_enter(ring_fd_, to_submit_, block ? 1 : 0, block ? IORING_ENTER_GETEVENTS : 0);
+            if (result >= 0) {
+                to_submit_ -= std::min(to_submit_, static_cast<unsigned>(result));
+            } else if (errno == EINTR) {
+                continue;
+            } else if (errno != EAGAIN && errno != EBUSY) {
+                return;
+            }
+        }
+
+        unsigned head = *cq_head_;
+        const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            const io_uring_cqe& cqe = cqes_[head & *cq_mask_];
+            complete(static_cast<size_t>(cqe.user_data >> 2), static_cast<Op>(cqe.user_data & 3), cqe.res, done);
+        }
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+
+        // Reads queued by those completions still have to go out
+        const bool satisfied = !wait || done.size() > before || in_flight_ == 0;
+        if (satisfied && to_submit_ == 0) {
+            return;
+        }
+    }
+}
+
+void UringReader::complete(size_t slot, Op op, int result, std::vector<Completed>& done) {
+    Request& request = requests_[slot];
+    --request.outstanding;
+
+    if (op == OPEN) {
+        if (result < 0) {
+            request.error = -result;
+        } else {
+            request.fd = result;
+        }
+    } else if (op == STAT) {
+        if (result < 0 && request.error == 0) {
+            request.error = -result;
+        }
+    } else if (result < 0) {
+        if (result == -EINTR || result == -EAGAIN) {
+            queue_read(slot);
+            return;
+        }
+        request.error = -result;
+        finish(slot, done);
+        return;
+    } else if (result == 0) {
+        // The file shrank after statx
+        request.data.resize(request.filled);
+        finish(slot, done);
+        return;
+    } else {
+        request.filled += static_cast<size_t>(result);
+        if (request.filled < request.data.size()) {
+            queue_read(slot);
+        } else {
+            finish(slot, done);
+        }
+        return;
+    }
+
+    // Open and stat both answered
+    if (request.outstanding > 0) {
+        return;
+    }
+    if (request.error != 0) {
+        finish(slot, done);
+        return;
+    }
+    const auto& stat = *reinterpret_cast<const struct statx*>(request.stat);
+    if (stat.stx_size > max_size_) {
+        finish(slot, done, true);
+        return;
+    }
+    if (stat.stx_size == 0) {
+        finish(slot, done);
+        return;
+    }
+    request.data.resize(static_cast<size_t>(stat.stx_size));
+    queue_read(slot);
+}
+
+void UringReader::finish(size_t slot, std::vector<Completed>& done, bool too_large) {
+    Request& request = requests_[slot];
+    if (request.fd >= 0) {
+        close(request.fd);
+    }
+
+    Completed completed;
+    completed.path = std::move(request.path);
+    completed.error = request.error;
+    completed.too_large = too_large;
+    if (request.error == 0 && !too_large && !request.data.empty()) {
+        completed.contents = FileBuffer::from_string(std::move(request.data));
+    }
+    done.push_back(std::move(completed));
+
+    request = Request();
+    free_slots_.push_back(slot);
+    --in_flight_;
+}
+
+#else
+
+bool UringReader::available() {
+    return false;
+}
+
+UringReader::UringReader(unsigned depth, size_t max_size) : max_size_(max_size) {
+    (void)depth;
+}
+
+UringReader::~UringReader() = default;
+
+bool UringReader::submit(std::string path) {
+    (void)path;
+    return false;
+}
+
+void UringReader::reap(std::vector<Completed>& done, bool wait) {
+    (void)done;
+    (void)wait;
+}
+
+#endif
+
+} // namespace cpp_ripgrep
@@ -0,0 +1,64 @@
+#include "worker_pool.hpp"
+
+namespace cpp_ripgrep {
+
+WorkerPool::WorkerPool(size_t num_threads) : num_threads_(num_threads) {}
+
+WorkerPool::~WorkerPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    job_cv_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void WorkerPool::start(std::function<void(size_t)> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job_ = std::move(job);
+        running_ = num_threads_;
+        ++generation_;
+    }
+    if (threads_.empty()) {
+        threads_.reserve(num_threads_);
+        for (size_t i = 0; i < num_threads_; ++i) {
+            threads_.emplace_back(&WorkerPool::thread_main, this, i);
+        }
+    }
+    job_cv_.notify_all();
+}
+
+void WorkerPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return running_ == 0; });
+    job_ = nullptr;
+}
+
+void WorkerPool::thread_main(size_t index) {
+    size_t seen = 0;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        job_cv_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+        if (stopping_) {
+            return;
+        }
+        seen = generation_;
+
+        // job_ is only replaced after wait(), which needs this thread done
+        const auto& job = job_;
+        lock.unlock();
+        job(index);
+        lock.lock();
+
+        if (--running_ == 0) {
+            done_cv_.notify_all();
+        }
+    }
+}
+
+} // namespace cpp_ripgrep
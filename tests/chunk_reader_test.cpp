@@ -0,0 +1,82 @@
+#include "test_harness.hpp"
+#include "chunk_reader.hpp"
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+
+using namespace cpp_ripgrep;
+
+namespace {
+
+// Every chunk of contents read back with the given sizes
+std::vector<std::string> read_chunks(const std::string& contents, size_t chunk_size, size_t binary_probe,
+                                     size_t max_line_size) {
+    test::TempDir dir;
+    const std::string path = dir.write("data", contents);
+    ChunkReader reader(::open(path.c_str(), O_RDONLY), chunk_size, ChunkReader::Compression::NONE, binary_probe,
+                       max_line_size);
+    std::vector<std::string> chunks;
+    std::string_view chunk;
+    while (reader.next(chunk)) {
+        chunks.emplace_back(chunk);
+    }
+    return chunks;
+}
+
+std::string joined(const std::vector<std::string>& chunks) {
+    std::string all;
+    for (const auto& chunk : chunks) {
+        all += chunk;
+    }
+    return all;
+}
+
+} // namespace
+
+TEST_CASE(chunks_end_on_line_boundaries) {
+    std::string contents;
+    for (int i = 0; i < 2000; ++i) {
+        contents += "line " + std::to_string(i) + "\n";
+    }
+    contents += "last";
+    auto chunks = read_chunks(contents, 1000, 0, 4000);
+    CHECK(chunks.size() > 10);
+    CHECK(joined(chunks) == contents);
+    for (size_t i = 0; i + 1 < chunks.size(); ++i) {
+        CHECK(!chunks[i].empty() && chunks[i].back() == '\n');
+    }
+    CHECK_EQ(chunks.back().substr(chunks.back().size() - 4), std::string("last"));
+}
+
+TEST_CASE(long_lines_grow_the_buffer_up_to_the_cap) {
+    // A 3000-byte line fits once the 1000-byte buffer has grown
+    std::string contents = std::string(3000, 'a') + "\nb\n";
+    auto chunks = read_chunks(contents, 1000, 0, 4000);
+    CHECK(joined(chunks) == contents);
+    CHECK(chunks.front().size() >= 3001 && chunks.front().back() == '\n');
+}
+
+TEST_CASE(over_long_lines_come_in_pieces) {
+    // No newline at all: memory must stay at the cap, not the file size
+    std::string contents(100000, 'x');
+    contents[50000] = 'y';
+    auto chunks = read_chunks(contents, 1000, 0, 4096);
+    CHECK(joined(chunks) == contents);
+    for (const auto& chunk : chunks) {
+        CHECK(chunk.size() <= 4096);
+    }
+}
+
+TEST_CASE(binary_probe_stops_after_the_first_read) {
+    std::string contents(100000, 'x');
+    contents[10] = '\0';
+    auto chunks = read_chunks(contents, 1000, 64, 4096);
+    CHECK_EQ(chunks.size(), size_t(1));
+    CHECK(chunks.size() == 1 && chunks[0].size() <= 1000 && chunks[0][10] == '\0');
+
+    // A NUL past the probe leaves the stream alone
+    contents[10] = 'x';
+    contents[500] = '\0';
+    chunks = read_chunks(contents, 1000, 64, 4096);
+    CHECK(joined(chunks) == contents);
+}
@@ -0,0 +1,119 @@
+#include "test_harness.hpp"
+#include "file_scanner.hpp"
+#include "glob.hpp"
+#include "glob_set.hpp"
+#include "options.hpp"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace cpp_ripgrep;
+
+TEST_CASE(glob_wildcards_stop_at_slashes) {
+    CHECK(Glob("*.cpp").matches("main.cpp"));
+    CHECK(!Glob("*.cpp").matches("src/main.cpp"));
+    CHECK(Glob("a?c").matches("abc"));
+    CHECK(!Glob("a?c").matches("a/c"));
+    CHECK(Glob("src/*.h").matches("src/a.h"));
+    CHECK(!Glob("src/*.h").matches("src/x/a.h"));
+    CHECK(Glob("name").matches("name"));
+    CHECK(!Glob("name").matches("names"));
+}
+
+TEST_CASE(glob_double_star_spans_directories) {
+    CHECK(Glob("**/test").matches("test"));
+    CHECK(Glob("**/test").matches("a/b/test"));
+    CHECK(Glob("src/**").matches("src/a/b.c"));
+    CHECK(Glob("a/**/b").matches("a/b"));
+    CHECK(Glob("a/**/b").matches("a/x/y/b"));
+    CHECK(!Glob("a/**/b").matches("a/xb"));
+    CHECK(!Glob("a**b").matches("a/b"));
+}
+
+TEST_CASE(glob_classes_and_escapes) {
+    CHECK(Glob("file[0-9]").matches("file7"));
+    CHECK(!Glob("file[0-9]").matches("filex"));
+    CHECK(Glob("file[!0-9]").matches("filex"));
+    CHECK(Glob("file[^0-9]").matches("filex"));
+    CHECK(!Glob("file[!0-9]").matches("file/"));
+    CHECK(Glob("[]]x").matches("]x"));
+    CHECK(Glob("a\\*b").matches("a*b"));
+    CHECK(!Glob("a\\*b").matches("axb"));
+}
+
+TEST_CASE(glob_set_agrees_with_glob) {
+    // Every shape GlobSet handles (hashes, the regex translation and the
+    // fallback) must decide like Glob itself
+    const std::vector<std::string> globs = {
+        "*.cpp", "Makefile", "src/main.cpp", "*_test.*", "**/gen/*.h", "docs/**", "a/**/z",
+        "file[0-9].txt", "file[!a-c]", "x?y", "[]]x", "a\\*b", "*.tar.gz", "[a-", "lib/*/include"};
+    const std::vector<std::string> paths = {
+        "main.cpp", "src/main.cpp", "Makefile", "src/Makefile", "util_test.cc", "gen/a.h", "x/gen/a.h",
+        "x/gen/y/a.h", "docs/a/b.md", "a/z", "a/b/c/z", "file5.txt", "filed", "filea", "xzy", "x/y",
+        "]x", "a*b", "axb", "pkg.tar.gz", "[a-", "lib/foo/include", "lib/foo/bar/include"};
+    for (const auto& pattern : globs) {
+        GlobSet set({GlobSet::Entry{pattern, 3}});
+        const bool whole_path = pattern.find('/') != std::string::npos;
+        Glob glob(pattern);
+        for (const auto& path : paths) {
+            std::string name = path.substr(path.rfind('/') == std::string::npos ? 0 : path.rfind('/') + 1);
+            const bool expected = glob.matches(whole_path ? path : name);
+            const bool actual = set.matches(path) == (1u << 3);
+            if (expected != actual) {
+                std::cerr << pattern << " on " << path << ": glob " << expected << ", set " << actual << "\n";
+            }
+            CHECK_EQ(actual, expected);
+            CHECK_EQ(set.matches("./" + path), set.matches(path));
+        }
+    }
+}
+
+TEST_CASE(glob_set_reports_every_tag) {
+    GlobSet set({GlobSet::Entry{"*.h", 0}, GlobSet::Entry{"include/**", 1}, GlobSet::Entry{"a.h", 2}});
+    CHECK_EQ(set.matches("include/a.h"), 7u);
+    CHECK_EQ(set.matches("src/b.h"), 1u);
+    CHECK_EQ(set.matches("include/x.c"), 2u);
+    CHECK_EQ(set.matches("x.c"), 0u);
+}
+
+TEST_CASE(excludes_prune_directories) {
+    test::TempDir tmp;
+    tmp.write("a.cpp", "x");
+    tmp.write("build/b.cpp", "x");
+    tmp.write("src/build", "x");
+    tmp.write("node_modules/x/d.js", "x");
+    tmp.write("src/out/e.cpp", "x");
+    tmp.write("src/out.cpp", "x");
+    tmp.write("src/gen/f.cpp", "x");
+
+    Options options;
+    options.no_ignore = true;
+    options.exclude_patterns = {"build", "node_modules", "out/", "**/src/gen"};
+    FileScanner scanner(options);
+
+    std::vector<std::string> found;
+    scanner.scan({tmp.path()}, [&](const FileInfo& info) {
+        found.push_back(info.path.substr(tmp.path().size() + 1));
+    });
+    std::sort(found.begin(), found.end());
+    std::string joined;
+    for (const auto& path : found) {
+        joined += path + ";";
+    }
+    // A plain exclude drops directories and files alike; "out/" only
+    // directories
+    CHECK_EQ(joined, std::string("a.cpp;src/out.cpp;"));
+
+    CHECK(!scanner.should_scan_directory("./build"));
+    CHECK(!scanner.should_scan_directory("lib/out"));
+    CHECK(scanner.should_scan_file("lib/out"));
+}
+
+TEST_CASE(includes_do_not_prune_directories) {
+    Options options;
+    options.include_patterns = {"*.cpp"};
+    FileScanner scanner(options);
+    CHECK(scanner.should_scan_directory("src"));
+    CHECK(scanner.should_scan_file("src/a.cpp"));
+    CHECK(!scanner.should_scan_file("src/a.h"));
+}
@@ -0,0 +1,277 @@
+#include "test_harness.hpp"
+#include "grep_engine.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <unistd.h>
+
+using namespace cpp_ripgrep;
+
+namespace {
+
+// A file large enough to be searched in several pieces, with a match in
+// every 64 KiB of it
+struct SplitFile {
+    test::TempDir dir;
+    std::string path = dir.file("split.txt");
+
+    SplitFile() {
+        std::string block(64 * 1024 - 6, 'x');
+        block[block.size() / 2] = '\n';
+        block += "\nneedle\n";
+        std::ofstream out(path, std::ios::binary);
+        for (int i = 0; i < 256; ++i) {
+            out << block;
+        }
+    }
+};
+
+Options split_options(const std::string& path) {
+    Options options;
+    options.pattern = "needle";
+    options.patterns = {"needle"};
+    options.paths = {path};
+    options.threads = 4;
+    options.split_threshold = 1024;
+    options.color = "never";
+    return options;
+}
+
+// Everything search() writes to standard output
+std::string captured_search(GrepEngine& engine) {
+    test::TempDir dir;
+    std::string capture_path = dir.file("stdout.txt");
+    std::fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    int fd = open(capture_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    dup2(fd, STDOUT_FILENO);
+    close(fd);
+    engine.search();
+    std::cout.flush();
+    std::fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+
+    std::ifstream in(capture_path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+struct CountingSink : SearchSink {
+    size_t lines = 0;
+    void match(const SinkMatch&) override { ++lines; }
+};
+
+} // namespace
+
+TEST_CASE(split_file_honors_max_count) {
+    SplitFile file;
+    Options options = split_options(file.path);
+    options.max_count = 3;
+
+    GrepEngine engine(options);
+    CHECK(engine.is_valid());
+    CountingSink sink;
+    SearchSummary summary = engine.search({file.path}, sink);
+    CHECK_EQ(sink.lines, size_t(3));
+    CHECK_EQ(summary.matched_lines, size_t(3));
+    CHECK_EQ(engine.get_match_count(), size_t(3));
+}
+
+TEST_CASE(split_file_count_and_stats_honor_max_count) {
+    SplitFile file;
+    Options options = split_options(file.path);
+    options.max_count = 3;
+    options.count_only = true;
+    options.stats = true;
+
+    GrepEngine engine(options);
+    std::string output = captured_search(engine);
+    CHECK(output.rfind("3\n", 0) == 0);
+    CHECK(output.find("Matched lines: 3\n") != std::string::npos);
+    CHECK(output.find("Files split: 1") != std::string::npos);
+}
+
+TEST_CASE(split_file_without_limit_counts_every_line) {
+    SplitFile file;
+    GrepEngine engine(split_options(file.path));
+    CountingSink sink;
+    SearchSummary summary = engine.search({file.path}, sink);
+    CHECK_EQ(summary.matched_lines, size_t(256));
+    CHECK_EQ(sink.lines, size_t(256));
+}
+
+namespace {
+
+// Line numbers the engine reports for pattern over contents
+std::string matching_lines(const std::string& pattern, RegexEngine engine_kind, const std::string& contents) {
+    test::TempDir dir;
+    std::string path = dir.write("lines.txt", contents);
+    Options options;
+    options.pattern = pattern;
+    options.patterns = {pattern};
+    options.mode = SearchMode::REGEX;
+    options.regex_engine = engine_kind;
+    options.threads = 1;
+
+    struct LineSink : SearchSink {
+        std::string lines;
+        void match(const SinkMatch& match) override { lines += std::to_string(match.line_number) + ";"; }
+    } sink;
+    GrepEngine engine(options);
+    CHECK(engine.is_valid());
+    engine.search({path}, sink);
+    return sink.lines;
+}
+
+} // namespace
+
+TEST_CASE(subject_anchors_apply_per_line) {
+    const std::string contents = "1 x\n2\n3 y\n4\n";
+    for (RegexEngine engine_kind : {RegexEngine::PCRE2, RegexEngine::RE2}) {
+        CHECK_EQ(matching_lines("\\d\\z", engine_kind, contents), std::string("2;4;"));
+        CHECK_EQ(matching_lines("2\\z", engine_kind, contents), std::string("2;"));
+        CHECK_EQ(matching_lines("\\A\\d", engine_kind, contents), std::string("1;2;3;4;"));
+        CHECK_EQ(matching_lines("\\Ax", engine_kind, contents), std::string(""));
+        CHECK_EQ(matching_lines("\\Ay", engine_kind, "x\ny\r\n"), std::string("2;"));
+        CHECK_EQ(matching_lines("\\\\z", engine_kind, "a\\z\nb\n"), std::string("1;"));
+    }
+    // \Z also allows a final newline, which a line never has
+    CHECK_EQ(matching_lines("\\d\\Z", RegexEngine::PCRE2, contents), std::string("2;4;"));
+}
+
+TEST_CASE(prefiltered_search_keeps_subject_anchors_on_the_line) {
+    // A required literal turns on the prefilter; the anchors must still
+    // see the candidate line as the whole subject
+    RegexMatcher pcre2("\\Afoo\\d\\z");
+    RE2Matcher re2("\\Afoo\\d\\z");
+    const std::string text = "x foo1\nfoo2\nfoo3 y\n";
+    for (int engine_kind = 0; engine_kind < 2; ++engine_kind) {
+        auto range = engine_kind == 0 ? pcre2.find_next(text, 0) : re2.find_next(text, 0);
+        CHECK(range.has_value());
+        if (range) {
+            CHECK_EQ(range->start, size_t(7));
+            CHECK_EQ(range->end, size_t(11));
+        }
+    }
+}
+
+TEST_CASE(sorted_search_can_run_again) {
+    test::TempDir dir;
+    for (int i = 0; i < 40; ++i) {
+        dir.write("d" + std::to_string(i % 5) + "/f" + std::to_string(i) + ".txt", "hit\nmiss\nhit\n");
+    }
+    Options options;
+    options.pattern = "hit";
+    options.patterns = {"hit"};
+    options.paths = {dir.path()};
+    options.threads = 4;
+    options.sort_files = true;
+    options.color = "never";
+
+    GrepEngine engine(options);
+    const std::string first = captured_search(engine);
+    CHECK_EQ(std::count(first.begin(), first.end(), '\n'), 80);
+    for (int run = 0; run < 5; ++run) {
+        CHECK(captured_search(engine) == first);
+    }
+}
+
+namespace {
+
+// Options as parsed from a command line
+Options parse_command_line(std::vector<std::string> args) {
+    std::vector<char*> argv;
+    for (auto& arg : args) {
+        argv.push_back(&arg[0]);
+    }
+    return OptionsParser::parse(static_cast<int>(argv.size()), argv.data());
+}
+
+// Options for the command line "rg [-F] -f indicators PATH"
+Options indicator_options(const std::string& indicators, const std::string& path, bool fixed_strings) {
+    std::vector<std::string> args = {"rg"};
+    if (fixed_strings) {
+        args.push_back("-F");
+    }
+    args.insert(args.end(), {"-f", indicators, "-j", "1", path});
+    return parse_command_line(args);
+}
+
+// "line:pattern;" for the first match on each matching line
+std::string indicator_hits(const Options& options, const std::string& path) {
+    struct HitSink : SearchSink {
+        std::string hits;
+        void match(const SinkMatch& match) override {
+            hits += std::to_string(match.line_number) + ":" +
+                    std::to_string(match.matches.empty() ? 0 : match.matches.front().pattern_index) + ";";
+        }
+    } sink;
+    GrepEngine engine(options);
+    CHECK(engine.is_valid());
+    if (!engine.is_valid()) {
+        return engine.get_error();
+    }
+    engine.search({path}, sink);
+    return sink.hits;
+}
+
+} // namespace
+
+TEST_CASE(thousands_of_dotted_indicators) {
+    test::TempDir dir;
+    std::string indicators;
+    for (int i = 0; i < 5000; ++i) {
+        indicators += "host" + std::to_string(i) + ".example.com\n";
+    }
+    const std::string indicator_path = dir.write("indicators.txt", indicators);
+    const std::string path = dir.write("log.txt",
+        "connect host4999.example.com ok\n"
+        "host17.example.com\n"
+        "host17xexample.com\n"
+        "nothing here\n"
+        "HOST2.EXAMPLE.COM\n");
+
+    // -F sends the list to Aho-Corasick, where '.' is only a dot
+    Options fixed = indicator_options(indicator_path, path, true);
+    CHECK(fixed.mode == SearchMode::MULTI_LITERAL);
+    CHECK_EQ(indicator_hits(fixed, path), std::string("1:4999;2:17;"));
+
+    // As regexes the set is split across several PCRE2 programs instead of
+    // one alternation too large to compile
+    Options regex = indicator_options(indicator_path, path, false);
+    CHECK(regex.mode == SearchMode::REGEX);
+    CHECK_EQ(indicator_hits(regex, path), std::string("1:4999;2:17;3:17;"));
+    RegexSetMatcher set(regex.patterns);
+    CHECK(set.is_valid());
+    CHECK(set.program_count() > 1);
+
+    regex.ignore_case = true;
+    regex.mode = SearchMode::CASE_INSENSITIVE;
+    CHECK_EQ(indicator_hits(regex, path), std::string("1:4999;2:17;3:17;5:2;"));
+}
+
+TEST_CASE(fixed_strings_match_metacharacters_literally) {
+    test::TempDir dir;
+    const std::string path = dir.write("lines.txt", "a.c\nabc\n(x|y)\nx\n");
+    Options options = parse_command_line({"rg", "-F", "-e", "a.c", "-e", "(x|y)", path});
+    CHECK_EQ(indicator_hits(options, path), std::string("1:0;3:1;"));
+
+    // A single caseless pattern still runs on the automaton
+    options = parse_command_line({"rg", "-F", "-i", "A.C", path});
+    CHECK(options.mode == SearchMode::MULTI_LITERAL);
+    CHECK_EQ(indicator_hits(options, path), std::string("1:0;"));
+}
+
+TEST_CASE(split_pattern_set_reports_the_invalid_pattern) {
+    std::vector<std::string> patterns;
+    for (int i = 0; i < 3000; ++i) {
+        patterns.push_back("host" + std::to_string(i) + ".example.com");
+    }
+    patterns[2500] = "bad(";
+    RegexSetMatcher set(patterns);
+    CHECK(!set.is_valid());
+    CHECK(set.get_error().rfind("pattern 2500: ", 0) == 0);
+}
@@ -0,0 +1,92 @@
+#include "test_harness.hpp"
+#include "ignore_rules.hpp"
+#include <string>
+
+using namespace cpp_ripgrep;
+
+namespace {
+
+// Rules of dir after writing its .gitignore (and .ignore, when given)
+IgnoreRules::Ptr load_rules(const test::TempDir& tmp, const std::string& dir, const std::string& gitignore,
+                            const std::string& ignore = std::string(), IgnoreRules::Ptr parent = nullptr) {
+    std::vector<std::string> files;
+    if (!gitignore.empty()) {
+        tmp.write(dir + "/.gitignore", gitignore);
+        files.push_back(".gitignore");
+    }
+    if (!ignore.empty()) {
+        tmp.write(dir + "/.ignore", ignore);
+        files.push_back(".ignore");
+    }
+    return IgnoreRules::load(tmp.file(dir), files, std::move(parent));
+}
+
+} // namespace
+
+TEST_CASE(ignore_names_match_at_any_depth) {
+    test::TempDir tmp;
+    auto rules = load_rules(tmp, "root", "*.log\nbuild\n# comment\n\n");
+    const std::string root = tmp.file("root");
+    CHECK_EQ(rules->rule_count(), size_t(2));
+    CHECK(rules->is_ignored(root + "/a.log", false));
+    CHECK(rules->is_ignored(root + "/src/deep/b.log", false));
+    CHECK(rules->is_ignored(root + "/build", true));
+    CHECK(rules->is_ignored(root + "/src/build", false));
+    CHECK(!rules->is_ignored(root + "/a.txt", false));
+    CHECK(!rules->is_ignored(root + "/builder", true));
+}
+
+TEST_CASE(ignore_slashes_anchor_and_mark_directories) {
+    test::TempDir tmp;
+    auto rules = load_rules(tmp, "root", "/top.txt\ndoc/*.md\nout/\n");
+    const std::string root = tmp.file("root");
+    CHECK(rules->is_ignored(root + "/top.txt", false));
+    CHECK(!rules->is_ignored(root + "/sub/top.txt", false));
+    CHECK(rules->is_ignored(root + "/doc/a.md", false));
+    CHECK(!rules->is_ignored(root + "/sub/doc/a.md", false));
+    CHECK(rules->is_ignored(root + "/out", true));
+    CHECK(rules->is_ignored(root + "/sub/out", true));
+    CHECK(!rules->is_ignored(root + "/out", false));
+}
+
+TEST_CASE(ignore_double_star_and_classes) {
+    test::TempDir tmp;
+    auto rules = load_rules(tmp, "root", "**/gen/*.cc\nlogs/**\nfile[0-9].txt\ntmp?\n");
+    const std::string root = tmp.file("root");
+    CHECK(rules->is_ignored(root + "/gen/a.cc", false));
+    CHECK(rules->is_ignored(root + "/x/y/gen/a.cc", false));
+    CHECK(!rules->is_ignored(root + "/x/gen/sub/a.cc", false));
+    CHECK(rules->is_ignored(root + "/logs/a/b.txt", false));
+    CHECK(rules->is_ignored(root + "/file7.txt", false));
+    CHECK(!rules->is_ignored(root + "/filex.txt", false));
+    CHECK(rules->is_ignored(root + "/tmp1", false));
+    CHECK(!rules->is_ignored(root + "/tmp12", false));
+}
+
+TEST_CASE(ignore_negation_and_order) {
+    test::TempDir tmp;
+    // The last matching rule wins, and .ignore comes after .gitignore
+    auto rules = load_rules(tmp, "root", "*.log\n!keep.log\n\\!bang\n", "keep.log\n!other.log\n");
+    const std::string root = tmp.file("root");
+    CHECK(rules->is_ignored(root + "/a.log", false));
+    CHECK(rules->is_ignored(root + "/keep.log", false));
+    CHECK(!rules->is_ignored(root + "/other.log", false));
+    CHECK(rules->is_ignored(root + "/!bang", false));
+}
+
+TEST_CASE(ignore_rules_are_inherited) {
+    test::TempDir tmp;
+    auto parent = load_rules(tmp, "root", "*.tmp\n*.o\n");
+    auto child = load_rules(tmp, "root/lib", "!*.o\nlocal\n", std::string(), parent);
+    const std::string root = tmp.file("root");
+
+    // The innermost directory with a matching rule decides
+    CHECK(child->is_ignored(root + "/lib/a.tmp", false));
+    CHECK(!child->is_ignored(root + "/lib/a.o", false));
+    CHECK(child->is_ignored(root + "/lib/local", false));
+    CHECK(parent->is_ignored(root + "/a.o", false));
+    CHECK(!parent->is_ignored(root + "/local", false));
+
+    // A directory without ignore files shares its parent's rules
+    CHECK(IgnoreRules::load(tmp.file("root/lib/sub"), {}, child) == child);
+}
@@ -0,0 +1,49 @@
+#include "test_harness.hpp"
+#include "metadata_cache.hpp"
+#include <string>
+#include <unistd.h>
+
+using namespace cpp_ripgrep;
+
+namespace {
+
+FileIdentity identity(uint64_t inode) {
+    FileIdentity id;
+    id.device = 1;
+    id.inode = inode;
+    id.mtime = 1000;
+    id.size = 42;
+    return id;
+}
+
+} // namespace
+
+TEST_CASE(metadata_cache_keeps_saved_entries) {
+    test::TempDir dir;
+    const std::string path = dir.file("metadata.cache");
+
+    auto cache = MetadataCache::open(path);
+    cache->record(identity(7), MetadataCache::Kind::BINARY);
+    cache->record(identity(3), MetadataCache::Kind::TEXT);
+    std::string error;
+    CHECK(cache->save(error));
+    CHECK(access(path.c_str(), F_OK) == 0);
+
+    // A second search over the same files learns nothing new, so saving
+    // must not write the file again
+    unlink(path.c_str());
+    CHECK(cache->lookup(identity(7)) == MetadataCache::Kind::BINARY);
+    CHECK(cache->lookup(identity(3)) == MetadataCache::Kind::TEXT);
+    cache->record(identity(7), MetadataCache::Kind::BINARY);
+    cache->record(identity(3), MetadataCache::Kind::TEXT);
+    CHECK(cache->save(error));
+    CHECK(access(path.c_str(), F_OK) != 0);
+
+    // A changed file is still written, merged with what was saved before
+    cache->record(identity(5), MetadataCache::Kind::TEXT);
+    CHECK(cache->save(error));
+    auto reopened = MetadataCache::open(path);
+    CHECK(reopened->lookup(identity(3)) == MetadataCache::Kind::TEXT);
+    CHECK(reopened->lookup(identity(5)) == MetadataCache::Kind::TEXT);
+    CHECK(reopened->lookup(identity(7)) == MetadataCache::Kind::BINARY);
+}
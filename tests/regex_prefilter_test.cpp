@@ -0,0 +1,65 @@
+#include "test_harness.hpp"
+#include "re2_matcher.hpp"
+#include "regex_matcher.hpp"
+#include "regex_prefilter.hpp"
+#include <string>
+#include <vector>
+
+using namespace cpp_ripgrep;
+
+namespace {
+
+// Factors joined for readable failure messages
+std::string literals(const std::string& pattern) {
+    std::string joined;
+    for (const auto& factor : RegexPrefilter::required_literals(pattern)) {
+        joined += "[" + factor + "]";
+    }
+    return joined;
+}
+
+} // namespace
+
+TEST_CASE(required_literals_plain_factors) {
+    CHECK_EQ(literals("foo.*bar"), std::string("[foo][bar]"));
+    CHECK_EQ(literals("ab+c"), std::string("[ab][c]"));
+    CHECK_EQ(literals("foo|bar"), std::string(""));
+}
+
+TEST_CASE(required_literals_skip_escape_arguments) {
+    // The argument of an escape is never part of a literal
+    CHECK_EQ(literals("\\x41BC"), std::string("[BC]"));
+    CHECK_EQ(literals("\\x{41}BC"), std::string("[BC]"));
+    CHECK_EQ(literals("\\pLBC"), std::string("[BC]"));
+    CHECK_EQ(literals("\\PLBC"), std::string("[BC]"));
+    CHECK_EQ(literals("\\p{Lu}BC"), std::string("[BC]"));
+    CHECK_EQ(literals("\\101BC"), std::string("[BC]"));
+    CHECK_EQ(literals("(a)\\g1x"), std::string("[x]"));
+    CHECK_EQ(literals("(a)\\g{-1}x"), std::string("[x]"));
+    CHECK_EQ(literals("(?<n>a)\\k<n>x"), std::string("[x]"));
+    CHECK_EQ(literals("\\cAxy"), std::string("[xy]"));
+}
+
+TEST_CASE(required_literals_give_up_on_unparsed_escapes) {
+    CHECK_EQ(literals("abc\\o|xyz"), std::string(""));
+    CHECK_EQ(literals("abc\\p"), std::string(""));
+    CHECK_EQ(literals("abc\\g|xyz"), std::string(""));
+}
+
+TEST_CASE(escape_patterns_still_match) {
+    const std::string line = "ABC here";
+    for (const char* pattern : {"\\x41BC", "\\pLBC", "\\101BC", "\\x{41}BC"}) {
+        RE2Matcher re2(pattern);
+        if (re2.is_valid()) {
+            CHECK(re2.find_next(line, 0).has_value());
+        }
+        RegexMatcher pcre2(pattern);
+        if (pcre2.is_valid()) {
+            CHECK(pcre2.find_next(line, 0).has_value());
+        }
+    }
+    RegexMatcher backreference("(a)\\g1x");
+    if (backreference.is_valid()) {
+        CHECK(backreference.find_next("aax", 0).has_value());
+    }
+}
@@ -0,0 +1,99 @@
+#include "test_harness.hpp"
+#include "grep_engine.hpp"
+#include <mutex>
+#include <string>
+
+using namespace cpp_ripgrep;
+
+namespace {
+
+struct RecordingSink : SearchSink {
+    std::mutex mutex;
+    size_t lines = 0;
+    std::vector<std::string> errors;
+    std::vector<std::string> warnings;
+
+    void match(const SinkMatch&) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++lines;
+    }
+    void error(std::string_view path, std::string_view message) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        errors.push_back(std::string(path) + ": " + std::string(message));
+    }
+    void warning(std::string_view path, std::string_view message) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        warnings.push_back(std::string(path) + ": " + std::string(message));
+    }
+};
+
+struct TextFile {
+    test::TempDir dir;
+    std::string path = dir.write("text.txt", "alpha\nbeta\nalpha beta\n");
+};
+
+Options literal_options(const std::string& pattern) {
+    Options options;
+    options.pattern = pattern;
+    options.patterns = {pattern};
+    options.threads = 2;
+    return options;
+}
+
+} // namespace
+
+TEST_CASE(invalid_engine_does_not_search) {
+    TextFile file;
+    Options options = literal_options("alpha(");
+    options.mode = SearchMode::REGEX;
+    GrepEngine engine(options);
+    CHECK(!engine.is_valid());
+
+    RecordingSink sink;
+    SearchSummary summary = engine.search({file.path}, sink);
+    CHECK_EQ(summary.files_searched, size_t(0));
+    CHECK_EQ(summary.errors, size_t(1));
+    CHECK_EQ(sink.errors.size(), size_t(1));
+    CHECK_EQ(sink.lines, size_t(0));
+}
+
+TEST_CASE(missing_paths_go_to_the_sink) {
+    TextFile file;
+    GrepEngine engine(literal_options("alpha"));
+    RecordingSink sink;
+    SearchSummary summary = engine.search({file.path, "/nonexistent/cpp_ripgrep"}, sink);
+    CHECK_EQ(summary.matched_lines, size_t(2));
+    CHECK_EQ(summary.errors, size_t(0));
+    CHECK_EQ(sink.warnings.size(), size_t(1));
+    CHECK(sink.warnings.empty() || sink.warnings[0].find("/nonexistent/cpp_ripgrep") == 0);
+}
+
+TEST_CASE(cancel_before_search_is_kept) {
+    TextFile file;
+    GrepEngine engine(literal_options("alpha"));
+
+    engine.cancel();
+    RecordingSink cancelled;
+    SearchSummary summary = engine.search({file.path}, cancelled);
+    CHECK(summary.cancelled);
+    CHECK_EQ(cancelled.lines, size_t(0));
+
+    engine.reset_cancel();
+    RecordingSink resumed;
+    summary = engine.search({file.path}, resumed);
+    CHECK(!summary.cancelled);
+    CHECK_EQ(resumed.lines, size_t(2));
+}
+
+TEST_CASE(quiet_stop_does_not_cancel_the_next_search) {
+    TextFile file;
+    Options options = literal_options("beta");
+    options.quiet = true;
+    GrepEngine engine(options);
+    for (int i = 0; i < 2; ++i) {
+        RecordingSink sink;
+        SearchSummary summary = engine.search({file.path}, sink);
+        CHECK(!summary.cancelled);
+        CHECK_EQ(summary.files_matched, size_t(1));
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace cpp_ripgrep {
+namespace test {
+
+struct TestCase {
+    const char* name;
+    std::function<void()> body;
+};
+
+// Every TEST_CASE in the binary, in registration order
+std::vector<TestCase>& registry();
+
+// Failed checks in the test currently running
+int& failures();
+
+struct Registrar {
+    Registrar(const char* name, std::function<void()> body) {
+        registry().push_back(TestCase{name, std::move(body)});
+    }
+};
+
+// A fresh directory under the system temp directory, removed with its
+// contents when the test is done, so concurrent runs never share files
+class TempDir {
+public:
+    TempDir() {
+        std::string templ = (std::filesystem::temp_directory_path() / "cpp_ripgrep_test_XXXXXX").string();
+        if (mkdtemp(templ.data()) == nullptr) {
+            throw std::runtime_error("cannot create a temporary directory");
+        }
+        path_ = templ;
+    }
+
+    ~TempDir() {
+        std::error_code error;
+        std::filesystem::remove_all(path_, error);
+    }
+
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+
+    const std::string& path() const { return path_; }
+
+    // Path of name inside the directory
+    std::string file(const std::string& name) const { return path_ + "/" + name; }
+
+    // Write contents to name, creating its parent directories; returns its path
+    std::string write(const std::string& name, const std::string& contents) const {
+        std::string path = file(name);
+        std::filesystem::create_directories(std::filesystem::path(path).parent_path());
+        std::ofstream(path, std::ios::binary) << contents;
+        return path;
+    }
+
+private:
+    std::string path_;
+};
+
+} // namespace test
+} // namespace cpp_ripgrep
+
+#define TEST_CASE(name)                                                              \
+    static void name();                                                              \
+    static ::cpp_ripgrep::test::Registrar name##_registrar(#name, name);             \
+    static void name()
+
+// Record a failure and keep going, so one run reports every broken check
+#define CHECK(expr)                                                                  \
+    do {                                                                             \
+        if (!(expr)) {                                                               \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #expr ") failed\n"; \
+            ++::cpp_ripgrep::test::failures();                                       \
+        }                                                                            \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                   \
+    do {                                                                             \
+        const auto& actual_value = (actual);                                         \
+        const auto& expected_value = (expected);                                     \
+        if (!(actual_value == expected_value)) {                                     \
+            std::ostringstream message;                                              \
+            message << __FILE__ << ":" << __LINE__ << ": CHECK_EQ(" #actual ", " #expected \
+                    << ") failed: got " << actual_value << ", expected " << expected_value; \
+            std::cerr << message.str() << "\n";                                      \
+            ++::cpp_ripgrep::test::failures();                                       \
+        }                                                                            \
+    } while (0)
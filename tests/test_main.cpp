@@ -0,0 +1,44 @@
+#include "test_harness.hpp"
+#include <cstring>
+
+namespace cpp_ripgrep {
+namespace test {
+
+std::vector<TestCase>& registry() {
+    static std::vector<TestCase> cases;
+    return cases;
+}
+
+int& failures() {
+    static int count = 0;
+    return count;
+}
+
+} // namespace test
+} // namespace cpp_ripgrep
+
+// Runs every test, or those whose name contains argv[1]
+int main(int argc, char* argv[]) {
+    using namespace cpp_ripgrep::test;
+    int failed = 0;
+    int run = 0;
+    for (const auto& test : registry()) {
+        if (argc > 1 && std::strstr(test.name, argv[1]) == nullptr) {
+            continue;
+        }
+        ++run;
+        failures() = 0;
+        try {
+            test.body();
+        } catch (const std::exception& e) {
+            std::cerr << test.name << ": unexpected exception: " << e.what() << "\n";
+            ++failures();
+        }
+        if (failures() > 0) {
+            std::cerr << "FAILED " << test.name << "\n";
+            ++failed;
+        }
+    }
+    std::cout << run - failed << "/" << run << " tests passed\n";
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,110 @@
+#include "test_harness.hpp"
+#include "options.hpp"
+#include "regex_matcher.hpp"
+#include "trigram_index.hpp"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace cpp_ripgrep;
+
+namespace {
+
+// Index the given file contents in a scratch directory
+struct IndexedFiles {
+    test::TempDir dir;
+    std::vector<std::string> paths;
+    std::vector<std::string> contents;
+    std::unique_ptr<TrigramIndex> index;
+
+    explicit IndexedFiles(const std::vector<std::string>& files) : contents(files) {
+        TrigramIndexBuilder builder(nullptr);
+        TrigramCollector collector;
+        for (size_t i = 0; i < files.size(); ++i) {
+            paths.push_back(dir.write("file" + std::to_string(i), files[i]));
+            collector.add(files[i]);
+            builder.add(paths.back(), *FileStamp::of(paths.back()), collector.take());
+        }
+        std::string error;
+        CHECK(builder.write(dir.file("index"), error));
+        index = TrigramIndex::open(dir.file("index"), error);
+        CHECK(index != nullptr);
+    }
+};
+
+} // namespace
+
+TEST_CASE(index_agrees_with_scan_on_escapes) {
+    IndexedFiles files({"ABCD\n", "xyz\n", "A1 BCD\n", "aax\n", "prefix LBCD\n", "\x01xy\n"});
+    if (!files.index) {
+        return;
+    }
+
+    // Each pattern with the files it matches, so neither side can hide a
+    // bug that the prefilter shares with the other
+    const std::vector<std::pair<std::string, std::vector<size_t>>> cases = {
+        {"\\x41BCD", {0}},
+        {"\\x{41}BCD", {0}},
+        {"\\pLBCD", {0, 4}},
+        {"\\101BCD", {0}},
+        {"(a)\\g1x", {3}},
+        {"\\cAxy", {5}},
+        {"A\\d BCD", {2}},
+        {"\\QABC\\E", {0}},
+    };
+    for (const auto& [pattern, expected] : cases) {
+        Options options;
+        options.mode = SearchMode::REGEX;
+        options.pattern = pattern;
+        options.patterns = {pattern};
+        std::vector<bool> candidates = files.index->candidates(TrigramQuery::plan(options));
+
+        RegexMatcher matcher(pattern);
+        CHECK(matcher.is_valid());
+        for (size_t i = 0; i < files.paths.size(); ++i) {
+            const bool matches = std::find(expected.begin(), expected.end(), i) != expected.end();
+            const bool scanned = matcher.find_next(files.contents[i], 0).has_value();
+            uint32_t id = files.index->find(files.paths[i]);
+            CHECK(id != TrigramIndex::kNoFile);
+            if (scanned != matches || (matches && id != TrigramIndex::kNoFile && !candidates[id])) {
+                std::cerr << pattern << " on file" << i << ": expected " << matches << ", scan "
+                          << scanned << ", index " << (id != TrigramIndex::kNoFile && candidates[id]) << "\n";
+            }
+            CHECK_EQ(scanned, matches);
+            if (matches && id != TrigramIndex::kNoFile) {
+                CHECK(candidates[id]);
+            }
+        }
+    }
+}
+
+TEST_CASE(caseless_index_keeps_non_ascii_folds) {
+    IndexedFiles files({"CAF\xc3\x89 au lait\n", "tea\n"});
+    if (!files.index) {
+        return;
+    }
+
+    // The engines fold É to é; the index only folds ASCII
+    Options options;
+    options.mode = SearchMode::CASE_INSENSITIVE;
+    options.ignore_case = true;
+    options.pattern = "caf\xc3\xa9";
+    options.patterns = {options.pattern};
+    std::vector<bool> candidates = files.index->candidates(TrigramQuery::plan(options));
+    const uint32_t id = files.index->find(files.paths[0]);
+    CHECK(id != TrigramIndex::kNoFile);
+    if (id != TrigramIndex::kNoFile) {
+        CHECK(candidates[id]);
+    }
+
+    // ASCII-only trigrams still narrow the search
+    options.pattern = "caf\xc3\xa9 au lait";
+    options.patterns = {options.pattern};
+    candidates = files.index->candidates(TrigramQuery::plan(options));
+    const uint32_t other = files.index->find(files.paths[1]);
+    CHECK(other != TrigramIndex::kNoFile);
+    if (id != TrigramIndex::kNoFile && other != TrigramIndex::kNoFile) {
+        CHECK(candidates[id]);
+        CHECK(!candidates[other]);
+    }
+}